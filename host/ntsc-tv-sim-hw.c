@@ -0,0 +1,519 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pico/stdlib.h>
+#include <pico/multicore.h>
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/pio.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+#include <hardware/vreg.h>
+#include <hardware/structs/systick.h>
+#include "ntsc-tv-sim-hw.h"
+
+/* ===========================================================================
+ * Registers
+ * =========================================================================== */
+static dma_hw_t dma_registers __attribute__ ((aligned (1024)));
+static pwm_hw_t pwm_registers;
+static pio_hw_t pio_registers[2];
+static systick_hw_t systick_registers;
+
+dma_hw_t *dma_hw = &dma_registers;
+pwm_hw_t *pwm_hw = &pwm_registers;
+pio_hw_t *const pio0_hw = &pio_registers[0];
+pio_hw_t *const pio1_hw = &pio_registers[1];
+systick_hw_t *systick_hw = &systick_registers;
+
+static uint32_t sys_clock_hz = 125000000;
+static sim_sink_t sim_sink;
+static sim_source_t sim_source;
+
+void sim_set_sink(const sim_sink_t sink) {
+    sim_sink = sink;
+}
+
+void sim_set_source(const sim_source_t source) {
+    sim_source = source;
+}
+
+/* ===========================================================================
+ * DMA
+ * =========================================================================== */
+// Base register a channel register offset (in registers) stands for, per
+// alias: READ_ADDR, WRITE_ADDR, TRANS_COUNT, CTRL. The last register of
+// each alias triggers the channel
+enum { REG_READ, REG_WRITE, REG_COUNT, REG_CTRL };
+static const uint8_t dma_alias_registers[16] = {
+    REG_READ, REG_WRITE, REG_COUNT, REG_CTRL,
+    REG_CTRL, REG_READ, REG_WRITE, REG_COUNT,
+    REG_CTRL, REG_COUNT, REG_READ, REG_WRITE,
+    REG_CTRL, REG_WRITE, REG_COUNT, REG_READ,
+};
+
+// TRANS_COUNT as written, reloaded into the live count on every trigger
+static uint32_t dma_reload_count[NUM_DMA_CHANNELS];
+static uint dma_lowest_unclaimed;
+
+static uint dma_ctrl_field(const uint channel, const uint32_t bits, const uint lsb) {
+    return (uint) (dma_hw->ch[channel].ctrl_trig & bits) >> lsb;
+}
+
+static bool dma_is_video_paced(const uint channel) {
+    const uint treq = dma_ctrl_field(channel, DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS, DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB);
+    return treq < DREQ_PIO0_TX0 + 4 || (treq >= DREQ_PIO1_TX0 && treq < DREQ_PIO1_TX0 + 4) ||
+           (treq >= DREQ_PWM_WRAP0 && treq < DREQ_PWM_WRAP0 + 8);
+}
+
+// PIO block and state machine of the RX FIFO pacing `channel`, false if
+// it isn't paced by one
+static bool dma_rx_fifo(const uint channel, PIO *pio, uint *sm) {
+    const uint treq = dma_ctrl_field(channel, DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS, DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB);
+    if (treq >= DREQ_PIO0_RX0 && treq < DREQ_PIO0_RX0 + 4) {
+        *pio = pio0;
+        *sm = treq - DREQ_PIO0_RX0;
+        return true;
+    }
+    if (treq >= DREQ_PIO1_RX0 && treq < DREQ_PIO1_RX0 + 4) {
+        *pio = pio1;
+        *sm = treq - DREQ_PIO1_RX0;
+        return true;
+    }
+    return false;
+}
+
+static bool dma_is_unpaced(const uint channel) {
+    return dma_ctrl_field(channel, DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS, DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB) == DREQ_FORCE;
+}
+
+static void dma_trigger(const uint channel) {
+    dma_channel_hw_t *ch = &dma_hw->ch[channel];
+    if (!(ch->ctrl_trig & DMA_CH0_CTRL_TRIG_EN_BITS))
+        return;
+    ch->transfer_count = dma_reload_count[channel];
+    ch->ctrl_trig |= DMA_CH0_CTRL_TRIG_BUSY_BITS;
+}
+
+// Register `index` of `channel` (0 to 15, any alias) was written with `value`
+static void dma_write_register(const uint channel, const uint index, const uintptr_t value) {
+    dma_channel_hw_t *ch = &dma_hw->ch[channel];
+    switch (dma_alias_registers[index]) {
+        case REG_READ:
+            ch->read_addr = value;
+            break;
+        case REG_WRITE:
+            ch->write_addr = value;
+            break;
+        case REG_COUNT:
+            dma_reload_count[channel] = (uint32_t) value;
+            break;
+        default:
+            ch->ctrl_trig = ((uint32_t) value & ~DMA_CH0_CTRL_TRIG_BUSY_BITS) | (ch->ctrl_trig & DMA_CH0_CTRL_TRIG_BUSY_BITS);
+            break;
+    }
+    if (index % 4 != 3)
+        return;
+    // A null trigger ends a control block chain: no transfer, just the interrupt
+    if (value)
+        dma_trigger(channel);
+    else
+        dma_hw->intr |= 1u << channel;
+}
+
+// Store `size` bytes at `address`, with register semantics in DMA register space
+static void dma_store(const uintptr_t address, const void *data, const uint size) {
+    const uintptr_t registers = (uintptr_t) dma_hw->ch;
+    if (address < registers || address >= registers + sizeof(dma_hw->ch)) {
+        memcpy((void *) address, data, size);
+        return;
+    }
+    memcpy((void *) address, data, size);
+    // A register takes effect once its last byte is written
+    const uintptr_t offset = address - registers;
+    if ((offset + size) % sizeof(dma_reg_t))
+        return;
+    const uint index = (uint) (offset / sizeof(dma_reg_t));
+    const uintptr_t value = *(const volatile dma_reg_t *) (registers + index * sizeof(dma_reg_t));
+    dma_write_register(index / 16, index % 16, value);
+}
+
+static uintptr_t dma_advance(const uintptr_t address, const uint size, const bool ring, const uint ring_bits) {
+    if (!ring || !ring_bits)
+        return address + size;
+    const uintptr_t mask = ((uintptr_t) 1 << ring_bits) - 1;
+    return (address & ~mask) | ((address + size) & mask);
+}
+
+// Move one element on `channel`, completing the channel after its last one
+static void dma_transfer(const uint channel) {
+    dma_channel_hw_t *ch = &dma_hw->ch[channel];
+    const uint size = 1u << dma_ctrl_field(channel, DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS, DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+    const uint ring_bits = dma_ctrl_field(channel, DMA_CH0_CTRL_TRIG_RING_SIZE_BITS, DMA_CH0_CTRL_TRIG_RING_SIZE_LSB);
+    const bool ring_write = ch->ctrl_trig & DMA_CH0_CTRL_TRIG_RING_SEL_BITS;
+    const uintptr_t read_addr = ch->read_addr;
+    const uintptr_t write_addr = ch->write_addr;
+
+    uint8_t data[4];
+    memcpy(data, (const void *) read_addr, size);
+    if (ch->ctrl_trig & DMA_CH0_CTRL_TRIG_INCR_READ_BITS)
+        ch->read_addr = dma_advance(read_addr, size, !ring_write, ring_bits);
+    if (ch->ctrl_trig & DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS)
+        ch->write_addr = dma_advance(write_addr, size, ring_write, ring_bits);
+    const bool last = --ch->transfer_count == 0;
+    if (last)
+        ch->ctrl_trig &= ~DMA_CH0_CTRL_TRIG_BUSY_BITS;
+
+    dma_store(write_addr, data, size);
+    if (sim_sink && dma_is_video_paced(channel))
+        sim_sink(data, size);
+
+    if (!last)
+        return;
+    if (!(ch->ctrl_trig & DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS))
+        dma_hw->intr |= 1u << channel;
+    const uint chain_to = dma_ctrl_field(channel, DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS, DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+    if (chain_to != channel)
+        dma_trigger(chain_to);
+}
+
+int dma_claim_unused_channel(const bool required) {
+    if (dma_lowest_unclaimed == NUM_DMA_CHANNELS) {
+        if (required) {
+            fprintf(stderr, "sim: no free DMA channel\n");
+            abort();
+        }
+        return -1;
+    }
+    return (int) dma_lowest_unclaimed++;
+}
+
+void dma_channel_configure(const uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, const uint transfer_count, const bool trigger) {
+    dma_write_register(channel, 0, (uintptr_t) read_addr);
+    dma_write_register(channel, 1, (uintptr_t) write_addr);
+    dma_write_register(channel, 2, transfer_count);
+    dma_write_register(channel, trigger ? 3 : 4, config->ctrl);
+}
+
+void dma_channel_set_read_addr(const uint channel, const volatile void *read_addr, const bool trigger) {
+    dma_write_register(channel, trigger ? 15 : 0, (uintptr_t) read_addr);
+}
+
+void dma_channel_set_write_addr(const uint channel, volatile void *write_addr, const bool trigger) {
+    dma_write_register(channel, trigger ? 11 : 1, (uintptr_t) write_addr);
+}
+
+void dma_channel_set_trans_count(const uint channel, const uint32_t trans_count, const bool trigger) {
+    dma_write_register(channel, trigger ? 7 : 2, trans_count);
+}
+
+void dma_start_channel_mask(const uint32_t chan_mask) {
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+        if (chan_mask & 1u << channel)
+            dma_trigger(channel);
+}
+
+bool dma_channel_is_busy(const uint channel) {
+    return dma_hw->ch[channel].ctrl_trig & DMA_CH0_CTRL_TRIG_BUSY_BITS;
+}
+
+void dma_irqn_set_channel_mask_enabled(const uint irq_index, const uint32_t channel_mask, const bool enabled) {
+    volatile uint32_t *inte = irq_index ? &dma_hw->inte1 : &dma_hw->inte0;
+    *inte = enabled ? *inte | channel_mask : *inte & ~channel_mask;
+}
+
+/* ===========================================================================
+ * Interrupts
+ * =========================================================================== */
+#define IRQ_COUNT           32
+#define IRQ_HANDLERS_PER_IRQ 4
+
+static irq_handler_t irq_handlers[IRQ_COUNT][IRQ_HANDLERS_PER_IRQ];
+static bool irq_enabled[IRQ_COUNT];
+
+void irq_set_exclusive_handler(const uint num, const irq_handler_t handler) {
+    irq_handlers[num][0] = handler;
+}
+
+void irq_add_shared_handler(const uint num, const irq_handler_t handler, const uint8_t order_priority) {
+    (void) order_priority;
+    for (uint i = 0; i < IRQ_HANDLERS_PER_IRQ; i++) {
+        if (!irq_handlers[num][i]) {
+            irq_handlers[num][i] = handler;
+            return;
+        }
+    }
+    fprintf(stderr, "sim: too many handlers on IRQ %u\n", num);
+    abort();
+}
+
+void irq_set_priority(const uint num, const uint8_t hardware_priority) {
+    (void) num;
+    (void) hardware_priority;
+}
+
+void irq_set_enabled(const uint num, const bool enabled) {
+    irq_enabled[num] = enabled;
+}
+
+// Run the handlers of a raised DMA interrupt, true if there was one
+static bool irq_dispatch() {
+    for (uint irq_index = 0; irq_index < 2; irq_index++) {
+        volatile uint32_t *ints = irq_index ? &dma_hw->ints1 : &dma_hw->ints0;
+        const uint32_t pending = dma_hw->intr & (irq_index ? dma_hw->inte1 : dma_hw->inte0);
+        if (!pending || !irq_enabled[DMA_IRQ_0 + irq_index])
+            continue;
+        // Handlers acknowledge through INTS, the model clears the raised
+        // flags once they return
+        *ints = pending;
+        for (uint i = 0; i < IRQ_HANDLERS_PER_IRQ && irq_handlers[DMA_IRQ_0 + irq_index][i]; i++)
+            irq_handlers[DMA_IRQ_0 + irq_index][i]();
+        dma_hw->intr &= ~pending;
+        *ints = 0;
+        return true;
+    }
+    return false;
+}
+
+/* ===========================================================================
+ * Scheduler
+ * =========================================================================== */
+// Finish one unpaced channel or dispatch one interrupt, true if either ran
+static bool sim_run_immediate() {
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (dma_channel_is_busy(channel) && dma_is_unpaced(channel)) {
+            while (dma_channel_is_busy(channel))
+                dma_transfer(channel);
+            return true;
+        }
+    }
+    return irq_dispatch();
+}
+
+// Move one element on every running channel paced by an RX FIFO the
+// source has a word for
+static void sim_receive() {
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        PIO pio;
+        uint sm;
+        uint32_t word;
+        if (!sim_source || !dma_channel_is_busy(channel) || !dma_rx_fifo(channel, &pio, &sm) || !sim_source(pio, sm, &word))
+            continue;
+        pio->rxf[sm] = word;
+        dma_transfer(channel);
+        while (sim_run_immediate());
+    }
+}
+
+bool sim_dma_step(void) {
+    while (sim_run_immediate());
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (dma_channel_is_busy(channel) && dma_is_video_paced(channel)) {
+            dma_transfer(channel);
+            while (sim_run_immediate());
+            sim_receive();
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ===========================================================================
+ * Clocks, GPIO, PWM, PIO, spinlocks, cores and time
+ * =========================================================================== */
+void set_sys_clock_pll(const uint32_t vco_freq, const uint post_div1, const uint post_div2) {
+    sys_clock_hz = vco_freq / post_div1 / post_div2;
+}
+
+bool set_sys_clock_khz(const uint32_t freq_khz, const bool required) {
+    (void) required;
+    sys_clock_hz = freq_khz * 1000;
+    return true;
+}
+
+uint32_t clock_get_hz(const enum clock_index clk_index) {
+    (void) clk_index;
+    return sys_clock_hz;
+}
+
+void vreg_set_voltage(const enum vreg_voltage voltage) {
+    (void) voltage;
+}
+
+bool stdio_init_all(void) {
+    return true;
+}
+
+void gpio_set_function(const uint gpio, const enum gpio_function fn) {
+    (void) gpio;
+    (void) fn;
+}
+
+void gpio_init(const uint gpio) {
+    (void) gpio;
+}
+
+void gpio_set_dir(const uint gpio, const bool out) {
+    (void) gpio;
+    (void) out;
+}
+
+void gpio_put(const uint gpio, const bool value) {
+    (void) gpio;
+    (void) value;
+}
+
+pwm_config pwm_get_default_config(void) {
+    return (pwm_config) { .div = 1 << 4, .top = 0xffff };
+}
+
+void pwm_config_set_clkdiv(pwm_config *c, const float div) {
+    c->div = (uint32_t) (div * 16);
+}
+
+void pwm_init(const uint slice_num, pwm_config *c, const bool start) {
+    pwm_hw->slice[slice_num].div = c->div;
+    pwm_hw->slice[slice_num].top = c->top;
+    pwm_hw->slice[slice_num].csr = start;
+}
+
+void pwm_set_wrap(const uint slice_num, const uint16_t wrap) {
+    pwm_hw->slice[slice_num].top = wrap;
+}
+
+static uint pio_claimed_sms[2];
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void) pio;
+    (void) program;
+    return 0;
+}
+
+void pio_add_program_at_offset(PIO pio, const pio_program_t *program, const uint offset) {
+    (void) pio;
+    (void) program;
+    (void) offset;
+}
+
+int pio_claim_unused_sm(PIO pio, const bool required) {
+    uint *claimed = &pio_claimed_sms[pio_get_index(pio)];
+    for (int sm = 0; sm < 4; sm++) {
+        if (!(*claimed & 1u << sm)) {
+            *claimed |= 1u << sm;
+            return sm;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "sim: no free PIO state machine\n");
+        abort();
+    }
+    return -1;
+}
+
+pio_sm_config pio_get_default_sm_config(void) {
+    return (pio_sm_config) { 0 };
+}
+
+void sm_config_set_sideset(pio_sm_config *c, const uint bit_count, const bool optional, const bool pindirs) {
+    (void) c, (void) bit_count, (void) optional, (void) pindirs;
+}
+
+void sm_config_set_sideset_pins(pio_sm_config *c, const uint sideset_base) {
+    (void) c, (void) sideset_base;
+}
+
+void sm_config_set_out_pins(pio_sm_config *c, const uint out_base, const uint out_count) {
+    (void) c, (void) out_base, (void) out_count;
+}
+
+void sm_config_set_out_shift(pio_sm_config *c, const bool shift_right, const bool autopull, const uint pull_threshold) {
+    (void) c, (void) shift_right, (void) autopull, (void) pull_threshold;
+}
+
+void sm_config_set_fifo_join(pio_sm_config *c, const enum pio_fifo_join join) {
+    (void) c, (void) join;
+}
+
+void sm_config_set_wrap(pio_sm_config *c, const uint wrap_target, const uint wrap) {
+    (void) c, (void) wrap_target, (void) wrap;
+}
+
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, const uint16_t div_int, const uint8_t div_frac) {
+    (void) c, (void) div_int, (void) div_frac;
+}
+
+void pio_gpio_init(PIO pio, const uint pin) {
+    (void) pio, (void) pin;
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, const uint sm, const uint pin_base, const uint pin_count, const bool is_out) {
+    (void) pio, (void) sm, (void) pin_base, (void) pin_count, (void) is_out;
+    return 0;
+}
+
+int pio_sm_init(PIO pio, const uint sm, const uint initial_pc, const pio_sm_config *config) {
+    (void) pio, (void) sm, (void) initial_pc, (void) config;
+    return 0;
+}
+
+void pio_sm_set_enabled(PIO pio, const uint sm, const bool enabled) {
+    (void) pio, (void) sm, (void) enabled;
+}
+
+#define SPIN_LOCK_COUNT 32
+
+static spin_lock_t spin_locks[SPIN_LOCK_COUNT];
+static uint spin_locks_claimed;
+
+int spin_lock_claim_unused(const bool required) {
+    if (spin_locks_claimed == SPIN_LOCK_COUNT) {
+        if (required) {
+            fprintf(stderr, "sim: no free spinlock\n");
+            abort();
+        }
+        return -1;
+    }
+    return (int) spin_locks_claimed++;
+}
+
+spin_lock_t *spin_lock_instance(const uint lock_num) {
+    return &spin_locks[lock_num];
+}
+
+uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    if (*lock) {
+        fprintf(stderr, "sim: spinlock %u taken twice\n", (uint) (lock - spin_locks));
+        abort();
+    }
+    *lock = 1;
+    return 0;
+}
+
+void spin_unlock(spin_lock_t *lock, const uint32_t saved_irq) {
+    (void) saved_irq;
+    *lock = 0;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    (void) entry;
+    fprintf(stderr, "sim: core 1 is not simulated\n");
+    abort();
+}
+
+void multicore_lockout_victim_init(void) {
+}
+
+uint64_t time_us_64(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + (uint64_t) now.tv_nsec / 1000;
+}
+
+void sleep_ms(const uint32_t ms) {
+    const struct timespec duration = { .tv_sec = ms / 1000, .tv_nsec = (long) (ms % 1000) * 1000000 };
+    nanosleep(&duration, NULL);
+}
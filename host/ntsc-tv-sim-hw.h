@@ -0,0 +1,34 @@
+#ifndef NTSC_TV_SIM_HW_H
+#define NTSC_TV_SIM_HW_H
+
+#include <pico.h>
+#include <hardware/pio.h>
+
+// ------------------------------------------------------------
+// Simulated RP2040 peripherals behind the host SDK stand-in (sdk/).
+// Time advances one DMA transfer at a time: sim_dma_step() first runs
+// every unpaced transfer (control blocks) and the interrupt handlers they
+// raise to completion, then moves one element on the channel paced by a
+// video sink and one on each channel paced by a PIO RX FIFO the source has
+// a word for. Handlers take no simulated time, so the output is the
+// signal of a video core with zero interrupt latency
+// ------------------------------------------------------------
+
+// Receives each element a paced channel writes to a PWM compare register or
+// a PIO TX FIFO, `size` bytes in transfer order
+typedef void (*sim_sink_t)(const void *data, uint size);
+
+void sim_set_sink(sim_sink_t sink);
+
+// Supplies the words arriving in the PIO RX FIFO of state machine `sm`:
+// true with the next one in `word`, false while none has arrived. Only
+// asked while a channel paced by that FIFO is running, so a stopped
+// channel holds the sender off like the FIFO's flow control would
+typedef bool (*sim_source_t)(PIO pio, uint sm, uint32_t *word);
+
+void sim_set_source(sim_source_t source);
+
+// false once no channel is left transmitting to a video sink
+bool sim_dma_step(void);
+
+#endif // NTSC_TV_SIM_HW_H
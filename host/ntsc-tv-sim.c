@@ -0,0 +1,527 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pico/stdlib.h>
+
+#include <hardware/clocks.h>
+
+#if defined(NTSC_USE_INTERP) && NTSC_USE_INTERP
+#error "The interpolator is not simulated, build the simulator without NTSC_USE_INTERP"
+#endif
+
+// The simulated producer can't run while an interrupt handler encodes a
+// batch of rows, so the stream ring covers a whole control list refill
+#ifndef NTSC_STREAM_LINES
+#define NTSC_STREAM_LINES 16
+#endif
+
+// Stream lines arrive through ntsc_stream_start_dma() from a PIO RX FIFO,
+// one word per video sample, instead of being committed by the simulator
+#ifndef NTSC_SIM_STREAM_DMA
+#define NTSC_SIM_STREAM_DMA 0
+#endif
+
+// Draw the framebuffer like the demo's band renderer, each frame a new
+// picture in bands of 16 rows right behind the beam
+#ifndef NTSC_SIM_BANDS
+#define NTSC_SIM_BANDS 0
+#endif
+
+// The demo's VGA palette instead of RGB332, 1: built in through
+// NTSC_PALETTE_COLORS and checked against ntsc_set_color() sample by
+// sample, 2: set with ntsc_set_color() at run time, same checksum as 1
+#ifndef NTSC_SIM_VGA_PALETTE
+#define NTSC_SIM_VGA_PALETTE 0
+#endif
+
+#if NTSC_SIM_VGA_PALETTE
+#include "ntsc-tv-vga-palette.h"
+#if NTSC_SIM_VGA_PALETTE == 1
+#define NTSC_PALETTE_COLORS(COLOR) VGA_PALETTE_COLORS(COLOR)
+#endif
+#endif
+
+#include "ntsc-tv-out.h"
+#include "ntsc-tv-checker.h"
+#include "ntsc-tv-sim-hw.h"
+
+// ------------------------------------------------------------
+// Host-side signal simulator: runs the library's own ntsc_init() and DMA
+// interrupt handlers against the simulated DMA controller, captures one
+// whole frame of samples as they reach the PWM or PIO sink, and checks it
+// against an expected checksum or a golden dump, decodes it to an RGB
+// image or times the kernels
+//   ntsc-tv-sim [--frame N] [--checksum HASH] [--dump FILE] [--golden FILE] [--ppm FILE] [--bench]
+// ------------------------------------------------------------
+
+#define SIM_FRAME_SAMPLES (NTSC_TOTAL_LINES * NTSC_SAMPLES_PER_LINE)
+
+// Differences to list before only counting them
+#define SIM_MAX_REPORTED_DIFFERENCES 10
+
+static ntsc_sample_t sim_frame[SIM_FRAME_SAMPLES];
+
+// Frame to capture, the first one (0) is sent before any vertical blanking
+// work, e.g. a page flip or a palette commit, has run
+static uint sim_capture_frame = 1;
+
+// Bytes received by the sink since the video started
+static uint64_t sim_sink_bytes;
+
+static void sim_capture(const void *data, const uint size) {
+    const uint64_t frame_bytes = sizeof(sim_frame);
+    const uint64_t start = sim_capture_frame * frame_bytes;
+    if (sim_sink_bytes >= start && sim_sink_bytes < start + frame_bytes)
+        memcpy((uint8_t *) sim_frame + (sim_sink_bytes - start), data, size);
+    sim_sink_bytes += size;
+}
+
+/* ===========================================================================
+ * Picture
+ * =========================================================================== */
+#if NTSC_SIM_VGA_PALETTE
+#if NTSC_SIM_VGA_PALETTE == 1 && NTSC_PHASE_DITHER
+#error "NTSC_PHASE_DITHER fits the NTSC_PALETTE_COLORS list in ntsc_init(), there is no built-in palette to check"
+#endif
+
+#define SIM_VGA_RGB(rgb) rgb,
+static const uint32_t sim_vga_colors[] = { VGA_PALETTE_COLORS(SIM_VGA_RGB) };
+
+static void sim_set_vga_colors() {
+    for (uint i = 0; i < count_of(sim_vga_colors); i++) {
+        const uint32_t rgb = sim_vga_colors[i];
+        ntsc_set_color((uint8_t) i, rgb & 0xFF, rgb >> 16 & 0xFF, rgb >> 8 & 0xFF);
+    }
+}
+#endif
+
+#if NTSC_SIM_VGA_PALETTE == 1
+// Compare the built-in palette with what ntsc_set_color() gives for the
+// same colors, every sample of every palette line, 0 if they all match
+static int sim_check_palette() {
+    static ntsc_sample_t built_in[count_of(ntsc_palette)];
+    memcpy(built_in, ntsc_edit_palette, sizeof(built_in));
+    sim_set_vga_colors();
+    uint differences = 0;
+    for (uint i = 0; i < count_of(built_in); i++) {
+        if (built_in[i] == ntsc_edit_palette[i])
+            continue;
+        if (differences++ < SIM_MAX_REPORTED_DIFFERENCES)
+            printf("palette line %u color %u phase %u: built in %u, ntsc_set_color %u\n", i / NTSC_PALETTE_SIZE,
+                   i % NTSC_PALETTE_SIZE / 4, i % 4, (unsigned) built_in[i], (unsigned) ntsc_edit_palette[i]);
+    }
+    if (differences)
+        printf("%u palette samples differ\n", differences);
+    return differences != 0;
+}
+#endif
+
+// RGB332 palette, packed formats index its top entries, the same colors as
+// RGB565 pixels from checker_pixel(). The VGA palette is built in or set
+// from its list
+static void sim_init_palette() {
+#if NTSC_SIM_VGA_PALETTE == 2
+    sim_set_vga_colors();
+#elif !NTSC_SIM_VGA_PALETTE
+    for (uint i = 0; i < 256; i++) {
+        const uint color = NTSC_PIXEL_BITS < 8 ? (i << (8 - NTSC_PIXEL_BITS)) & 0xFF : i;
+        ntsc_set_color((uint8_t) i, (uint8_t) ((color & 3) * 255 / 3), (uint8_t) ((color >> 5) * 255 / 7),
+                       (uint8_t) ((color >> 2 & 7) * 255 / 7));
+    }
+#endif
+}
+
+#if NTSC_LINE_CALLBACK
+static void sim_line_callback(const uint row, uint8_t *pixels) {
+    checker_render_line(pixels, (int) row, 0);
+}
+#endif
+
+#if NTSC_STREAM_INPUT
+// Next row to stream, as a position in scan order
+static uint sim_stream_position;
+
+// Render the next row in scan order into `line`
+static void sim_stream_next_line(ntsc_stream_line_t *line) {
+    const uint field = sim_stream_position / NTSC_FIELD_ROWS;
+    line->row = (uint16_t) NTSC_FIELD_ROW(field, sim_stream_position % NTSC_FIELD_ROWS);
+    line->reserved = 0;
+    checker_render_line(line->pixels, line->row, 0);
+    sim_stream_position = (sim_stream_position + 1) % NTSC_FRAME_HEIGHT;
+}
+
+#if NTSC_SIM_STREAM_DMA
+// Stand-in for the host at the other end of the link: lines in their wire
+// format, a word whenever the DMA channel takes one
+static bool sim_stream_source(PIO pio, const uint sm, uint32_t *word) {
+    static ntsc_stream_line_t wire_line;
+    static uint wire_word;
+    (void) pio, (void) sm;
+    if (!wire_word)
+        sim_stream_next_line(&wire_line);
+    memcpy(word, (const uint8_t *) &wire_line + wire_word * 4, 4);
+    wire_word = (wire_word + 1) % (sizeof(wire_line) / 4);
+    return true;
+}
+#else
+// Stand-in for the host: keep the line ring full, rows in scan order
+static void sim_stream_fill() {
+    ntsc_stream_line_t *line;
+    while ((line = ntsc_stream_acquire())) {
+        sim_stream_next_line(line);
+        ntsc_stream_commit();
+    }
+}
+#endif
+#endif
+
+#if NTSC_SPRITE_COUNT
+#define SIM_SPRITE_SIZE 16
+
+// Filled circle in color 0xE0 on transparent 0
+static uint8_t sim_sprite_pixels[SIM_SPRITE_SIZE * SIM_SPRITE_SIZE];
+
+// Sprites spread over the picture, some partly off screen and some
+// overlapping, with their palette offsets walking the colors
+static void sim_init_sprites() {
+    for (int y = 0; y < SIM_SPRITE_SIZE; y++) {
+        for (int x = 0; x < SIM_SPRITE_SIZE; x++) {
+            const int dx = 2 * x + 1 - SIM_SPRITE_SIZE, dy = 2 * y + 1 - SIM_SPRITE_SIZE;
+            sim_sprite_pixels[y * SIM_SPRITE_SIZE + x] = dx * dx + dy * dy <= SIM_SPRITE_SIZE * SIM_SPRITE_SIZE ? 0xE0 : 0;
+        }
+    }
+    for (int i = 0; i < NTSC_SPRITE_COUNT; i++) {
+        ntsc_sprites[i] = (ntsc_sprite_t) {
+            .pixels = sim_sprite_pixels,
+            .x = (int16_t) (i * 37 % (NTSC_FRAME_WIDTH + SIM_SPRITE_SIZE) - SIM_SPRITE_SIZE / 2),
+            .y = (int16_t) (i * 23 % (NTSC_FRAME_HEIGHT + SIM_SPRITE_SIZE) - SIM_SPRITE_SIZE / 2),
+            .width = SIM_SPRITE_SIZE, .height = SIM_SPRITE_SIZE,
+            .transparent = 0,
+            .palette_offset = (uint8_t) (i * 3),
+        };
+    }
+}
+#endif
+
+#if NTSC_SIM_BANDS
+#if NTSC_PIXEL_BITS != 8 || !NTSC_HAS_FRAMEBUFFER || NTSC_DOUBLE_BUFFER || NTSC_SCROLL || NTSC_LINE_CACHE
+#error "NTSC_SIM_BANDS draws a single 8bpp framebuffer page, the one on air"
+#endif
+
+#define SIM_BAND_ROWS  16
+#define SIM_BAND_COUNT ((NTSC_FRAME_HEIGHT + SIM_BAND_ROWS - 1) / SIM_BAND_ROWS)
+
+// Picture being drawn, checker frame n, and its next band, SIM_BAND_COUNT
+// while waiting for the next frame to start
+static uint sim_band_picture;
+static uint sim_band_next = SIM_BAND_COUNT;
+static uint32_t sim_band_frame_start;
+
+// One step of the band renderer, run between DMA transfers. Drawing takes
+// no time, so a band is drawn as soon as the beam has sent its rows and
+// frame n + 1 shows picture n whole only if no band got ahead of the beam
+static void sim_band_step() {
+    if (sim_band_next == SIM_BAND_COUNT) {
+        // ntsc_wait_frame_start() without blocking
+        if (ntsc_is_rendering_active || ntsc_frame_counter % NTSC_FIELDS)
+            return;
+        sim_band_frame_start = ntsc_frame_counter;
+        sim_band_next = 0;
+    }
+    const int y0 = (int) sim_band_next * SIM_BAND_ROWS;
+    const int y1 = MIN(y0 + SIM_BAND_ROWS, NTSC_FRAME_HEIGHT);
+    if (ntsc_rows_sent(sim_band_frame_start) < (uint) y1)
+        return;
+    checker_render_rows(ntsc_framebuffer, NTSC_VIRTUAL_WIDTH, y0, y1, (int) sim_band_picture);
+    if (++sim_band_next == SIM_BAND_COUNT)
+        sim_band_picture++;
+}
+#endif
+
+// The demo's checkerboard in the configured video source, first frame only
+static void sim_init_picture() {
+    init_wave_lut(8.0f, 0.09f, 0.11f, 0.12f);
+    sim_init_palette();
+#if NTSC_SPRITE_COUNT
+    sim_init_sprites();
+#endif
+#if NTSC_TILE_MODE
+    for (uint i = 0; i < count_of(ntsc_tile_map); i++)
+        ntsc_tile_map[i] = (uint8_t) (i % NTSC_TILE_COUNT);
+    checker_render_tiles(ntsc_tile_patterns, NTSC_TILE_COUNT, 0);
+#elif NTSC_LINE_CALLBACK
+    ntsc_set_line_callback(sim_line_callback);
+#elif NTSC_STREAM_INPUT && NTSC_SIM_STREAM_DMA
+    sim_set_source(sim_stream_source);
+    ntsc_stream_start_dma(&pio0_hw->rxf[0], DREQ_PIO0_RX0, DMA_SIZE_32);
+#elif NTSC_STREAM_INPUT
+    sim_stream_fill();
+#elif NTSC_SIM_BANDS
+    // Drawn by sim_band_step(), frame 0 shows what gets drawn behind the beam
+#else
+#if NTSC_PIXEL_BITS != 8
+    checker_render_packed_frame(0);
+#else
+    checker_render_frame(ntsc_framebuffer, NTSC_VIRTUAL_WIDTH, NTSC_VIRTUAL_HEIGHT, 0);
+#endif
+#if NTSC_DOUBLE_BUFFER
+    // Shown from the captured frame on
+    ntsc_swap_buffers();
+#endif
+#endif
+}
+
+/* ===========================================================================
+ * Signal
+ * =========================================================================== */
+// Run the video until the captured frame is complete
+static void sim_run_frames(const uint frames) {
+    const uint64_t end = sim_sink_bytes + (uint64_t) frames * sizeof(sim_frame);
+    for (uint step = 0; sim_sink_bytes < end; step++) {
+#if NTSC_STREAM_INPUT && !NTSC_SIM_STREAM_DMA
+        // Top the ring up 4 times per scanline
+        if (step % (NTSC_TRANSFERS_PER_LINE / 4) == 0)
+            sim_stream_fill();
+#endif
+#if NTSC_SIM_BANDS
+        sim_band_step();
+#endif
+        if (!sim_dma_step()) {
+            fprintf(stderr, "ntsc-tv-sim: the video DMA stopped after %llu bytes\n", (unsigned long long) sim_sink_bytes);
+            exit(2);
+        }
+    }
+}
+
+// FNV-1a over the frame's samples, a short fingerprint of the signal
+static uint32_t sim_checksum() {
+    uint32_t hash = 2166136261u;
+    const uint8_t *bytes = (const uint8_t *) sim_frame;
+    for (size_t i = 0; i < sizeof(sim_frame); i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+static void sim_dump(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file || fwrite(sim_frame, sizeof(sim_frame), 1, file) != 1) {
+        fprintf(stderr, "ntsc-tv-sim: can't write %s\n", path);
+        exit(2);
+    }
+    fclose(file);
+}
+
+// Compare against a dump of an earlier run, 0 if the frame is identical
+static int sim_compare_golden(const char *path) {
+    static ntsc_sample_t golden[SIM_FRAME_SAMPLES];
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "ntsc-tv-sim: can't read %s\n", path);
+        exit(2);
+    }
+    const size_t read = fread(golden, 1, sizeof(golden), file);
+    const bool longer = fgetc(file) != EOF;
+    fclose(file);
+    if (read != sizeof(golden) || longer) {
+        printf("golden %s: %s frame, expected %zu bytes\n", path, longer ? "longer" : "shorter", sizeof(golden));
+        return 1;
+    }
+
+    uint differences = 0;
+    uint lines = 0;
+    for (uint line = 0; line < NTSC_TOTAL_LINES; line++) {
+        bool line_differs = false;
+        for (uint sample = 0; sample < NTSC_SAMPLES_PER_LINE; sample++) {
+            const uint i = line * NTSC_SAMPLES_PER_LINE + sample;
+            if (sim_frame[i] == golden[i])
+                continue;
+            if (differences++ < SIM_MAX_REPORTED_DIFFERENCES)
+                printf("line %3u sample %4u: %u, golden %u\n", line, sample, sim_frame[i], golden[i]);
+            line_differs = true;
+        }
+        lines += line_differs;
+    }
+    printf("golden %s: %s", path, differences ? "" : "identical\n");
+    if (differences)
+        printf("%u samples differ on %u lines\n", differences, lines);
+    return differences != 0;
+}
+
+/* ===========================================================================
+ * Decoder
+ * =========================================================================== */
+// Output level of a sample, in 1/65536 levels before NTSC_LEVEL() scaling,
+// the unit of NTSC_COMPOSITE_SIGNAL()
+static double sim_sample_signal(const ntsc_sample_t sample) {
+#if NTSC_SAMPLE_BITS == 8 && NTSC_OUTPUT != NTSC_OUTPUT_DAC
+    const uint level = sample ? (sample + 1u) / 2 : 0;
+#else
+    const uint level = sample;
+#endif
+    return level * 65536.0 / (1 << NTSC_LEVEL_SHIFT);
+}
+
+static uint8_t sim_clamp_component(const double component) {
+    return (uint8_t) (component < 0 ? 0 : component > 255 ? 255 : component + 0.5);
+}
+
+// Decode one pixel from the 4 samples around it, one per subcarrier phase:
+// luminance from their mean, (B-Y) and (R-Y) from the 0°-180° and
+// 90°-270° differences through the palette line's chroma weights. The
+// exact inverse of the encoder's modulation, not a TV's filters, so any
+// change to the encoded signal shows in the picture
+static void sim_decode_pixel(const ntsc_sample_t *line, const uint x, const uint palette_line, uint8_t rgb[3]) {
+    const uint center = NTSC_ACTIVE_START + x * NTSC_SAMPLES_PER_PIXEL + NTSC_SAMPLES_PER_PIXEL / 2;
+    const uint start = MIN(MAX(center, NTSC_ACTIVE_START + 2) - 2, NTSC_ACTIVE_START + NTSC_ACTIVE_SAMPLES - 4);
+    double signal[4];
+    for (uint i = start; i < start + 4; i++)
+        signal[(i - NTSC_ACTIVE_START) % 4] = sim_sample_signal(line[i]);
+
+    const int32_t (*weights)[2] = ntsc_chroma_weights[palette_line];
+    const double luminance = ((signal[0] + signal[1] + signal[2] + signal[3]) / 4 - 2 * 65536.0) / 1792;
+    const double chroma_0 = (signal[0] - signal[2]) / 2;
+    const double chroma_90 = (signal[1] - signal[3]) / 2;
+    const double determinant = (double) weights[0][0] * weights[1][1] - (double) weights[0][1] * weights[1][0];
+    const double blue = luminance + (chroma_0 * weights[1][1] - chroma_90 * weights[0][1]) / determinant;
+    const double red = luminance + (chroma_90 * weights[0][0] - chroma_0 * weights[1][0]) / determinant;
+    const double green = (256 * luminance - 29 * blue - 77 * red) / 150;
+
+    rgb[0] = sim_clamp_component(red);
+    rgb[1] = sim_clamp_component(green);
+    rgb[2] = sim_clamp_component(blue);
+}
+
+// Decode the captured frame's active video to a binary PPM, one pixel per
+// framebuffer pixel, the first of repeated lines
+static void sim_write_ppm(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "ntsc-tv-sim: can't write %s\n", path);
+        exit(2);
+    }
+    fprintf(file, "P6\n%d %d\n255\n", NTSC_FRAME_WIDTH, NTSC_FRAME_HEIGHT);
+    for (uint row = 0; row < NTSC_FRAME_HEIGHT; row++) {
+        const uint field = NTSC_FIELDS - 1 - row % NTSC_FIELDS;
+        const uint line = field * NTSC_FIELD_LINES + NTSC_ACTIVE_FIRST_LINE + row / NTSC_FIELDS * NTSC_LINE_REPEAT;
+        for (uint x = 0; x < NTSC_FRAME_WIDTH; x++) {
+            uint8_t rgb[3];
+            sim_decode_pixel(sim_frame + line * NTSC_SAMPLES_PER_LINE, x, ntsc_palette_line(row), rgb);
+            fwrite(rgb, 1, 3, file);
+        }
+    }
+    fclose(file);
+}
+
+/* ===========================================================================
+ * Benchmark
+ * =========================================================================== */
+static ntsc_sample_t sim_bench_line[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+
+static void sim_bench_encode_active_line(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        ntsc_encode_active_line(sim_bench_line, i % NTSC_FRAME_HEIGHT);
+}
+
+#if NTSC_DMA_ENGINE == NTSC_DMA_PINGPONG
+static void sim_bench_generate_scanline(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        ntsc_generate_scanline(i % NTSC_TOTAL_LINES);
+}
+#endif
+
+static void sim_bench_set_color(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        ntsc_set_color((uint8_t) i, (uint8_t) (i * 3), (uint8_t) (i * 5), (uint8_t) (i * 7));
+}
+
+// Whole frames through the DMA model and the interrupt handlers
+static void sim_bench_frame(const uint iterations) {
+    sim_run_frames(iterations);
+}
+
+typedef struct {
+    const char *name;
+    uint iterations;
+    void (*run)(uint iterations);
+} sim_bench_t;
+
+// Host timings of the same kernels as ntsc-tv-bench, for comparing
+// changes before they go on target, not for absolute numbers
+static void sim_bench_all() {
+    const sim_bench_t benches[] = {
+        { "encode_active_line", 1000 * NTSC_FRAME_HEIGHT, sim_bench_encode_active_line },
+#if NTSC_DMA_ENGINE == NTSC_DMA_PINGPONG
+        { "generate_scanline",  1000 * NTSC_TOTAL_LINES,  sim_bench_generate_scanline },
+#endif
+        { "set_color",          100 * 256,                sim_bench_set_color },
+        { "frame",              10,                       sim_bench_frame },
+    };
+    printf("%-20s %10s %12s\n", "bench", "iterations", "ns/iter");
+    for (uint i = 0; i < count_of(benches); i++) {
+        const uint64_t start_us = time_us_64();
+        benches[i].run(benches[i].iterations);
+        const uint64_t elapsed_us = time_us_64() - start_us;
+        printf("%-20s %10u %12.1f\n", benches[i].name, benches[i].iterations, elapsed_us * 1000.0 / benches[i].iterations);
+    }
+}
+
+int main(const int argc, char **argv) {
+    const char *dump_path = NULL;
+    const char *golden_path = NULL;
+    const char *ppm_path = NULL;
+    const char *expected_checksum = NULL;
+    bool bench = false;
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--frame") && has_value) {
+            sim_capture_frame = (uint) strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--checksum") && has_value) {
+            expected_checksum = argv[++i];
+        } else if (!strcmp(argv[i], "--dump") && has_value) {
+            dump_path = argv[++i];
+        } else if (!strcmp(argv[i], "--golden") && has_value) {
+            golden_path = argv[++i];
+        } else if (!strcmp(argv[i], "--ppm") && has_value) {
+            ppm_path = argv[++i];
+        } else if (!strcmp(argv[i], "--bench")) {
+            bench = true;
+        } else {
+            fprintf(stderr, "usage: %s [--frame N] [--checksum HASH] [--dump FILE] [--golden FILE] [--ppm FILE] [--bench]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int status = 0;
+#if NTSC_SIM_VGA_PALETTE == 1
+    status |= sim_check_palette();
+#endif
+    sim_set_sink(sim_capture);
+    sim_init_picture();
+    ntsc_init();
+    sim_run_frames(sim_capture_frame + 1);
+
+    printf("ntsc-tv-sim: %s, %s output, %lu MHz, %d-bit samples, %s engine, tiles %d, callback %d, stream %d, %dbpp, %dx%d\n",
+           ntsc_timing_profile.name, NTSC_OUTPUT == NTSC_OUTPUT_DAC ? "DAC" : "PWM", (unsigned long) (clock_get_hz(clk_sys) / 1000000),
+           NTSC_SAMPLE_BITS, NTSC_DMA_ENGINE == NTSC_DMA_CONTROL_LIST ? "control list" : "ping-pong",
+           NTSC_TILE_MODE, NTSC_LINE_CALLBACK, NTSC_STREAM_INPUT, NTSC_PIXEL_BITS, NTSC_FRAME_WIDTH, NTSC_FRAME_HEIGHT);
+    printf("frame %u: %d lines of %d samples, fnv1a 0x%08lx\n", sim_capture_frame, NTSC_TOTAL_LINES, NTSC_SAMPLES_PER_LINE,
+           (unsigned long) sim_checksum());
+#if NTSC_STREAM_INPUT
+    printf("stream: %lu underruns, %lu lines dropped\n", (unsigned long) ntsc_stream_underruns, (unsigned long) ntsc_stream_dropped);
+#endif
+
+    if (expected_checksum && strtoul(expected_checksum, NULL, 16) != sim_checksum()) {
+        printf("checksum differs, expected %s\n", expected_checksum);
+        status = 1;
+    }
+    if (dump_path)
+        sim_dump(dump_path);
+    if (golden_path)
+        status |= sim_compare_golden(golden_path);
+    if (ppm_path)
+        sim_write_ppm(ppm_path);
+    if (bench)
+        sim_bench_all();
+    return status;
+}
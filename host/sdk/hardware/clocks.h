@@ -0,0 +1,11 @@
+#ifndef NTSC_SIM_HARDWARE_CLOCKS_H
+#define NTSC_SIM_HARDWARE_CLOCKS_H
+
+#include <pico.h>
+
+enum clock_index { clk_gpout0 = 0, clk_ref = 4, clk_sys = 5, clk_peri = 6 };
+
+// The system clock last set with set_sys_clock_pll()
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif // NTSC_SIM_HARDWARE_CLOCKS_H
@@ -0,0 +1,136 @@
+#ifndef NTSC_SIM_HARDWARE_DMA_H
+#define NTSC_SIM_HARDWARE_DMA_H
+
+#include <pico.h>
+#include <hardware/irq.h>
+#include <hardware/regs/dreq.h>
+
+// ------------------------------------------------------------
+// DMA controller model, 12 channels with chaining, write rings, IRQ_QUIET
+// and the register aliases, run by sim_dma_step() (ntsc-tv-sim-hw.h)
+// Channel registers are pointer sized so that host addresses fit. Control
+// blocks copied into the alias registers then line up as long as they are
+// laid out like the registers they are loaded into (4 words on the RP2040)
+// ------------------------------------------------------------
+#define NUM_DMA_CHANNELS 12
+
+typedef uintptr_t dma_reg_t;
+
+typedef struct {
+    volatile dma_reg_t read_addr;
+    volatile dma_reg_t write_addr;
+    volatile dma_reg_t transfer_count;
+    volatile dma_reg_t ctrl_trig;
+    volatile dma_reg_t al1_ctrl;
+    volatile dma_reg_t al1_read_addr;
+    volatile dma_reg_t al1_write_addr;
+    volatile dma_reg_t al1_transfer_count_trig;
+    volatile dma_reg_t al2_ctrl;
+    volatile dma_reg_t al2_transfer_count;
+    volatile dma_reg_t al2_read_addr;
+    volatile dma_reg_t al2_write_addr_trig;
+    volatile dma_reg_t al3_ctrl;
+    volatile dma_reg_t al3_write_addr;
+    volatile dma_reg_t al3_transfer_count;
+    volatile dma_reg_t al3_read_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+    volatile uint32_t intr;
+    volatile uint32_t inte0;
+    volatile uint32_t intf0;
+    volatile uint32_t ints0;
+    volatile uint32_t inte1;
+    volatile uint32_t intf1;
+    volatile uint32_t ints1;
+} dma_hw_t;
+
+extern dma_hw_t *dma_hw;
+
+// CTRL register fields, as on the RP2040
+#define DMA_CH0_CTRL_TRIG_EN_BITS            0x00000001u
+#define DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS 0x00000002u
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB      2
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS     0x0000000cu
+#define DMA_CH0_CTRL_TRIG_INCR_READ_BITS     0x00000010u
+#define DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS    0x00000020u
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_LSB      6
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_BITS     0x000003c0u
+#define DMA_CH0_CTRL_TRIG_RING_SEL_BITS      0x00000400u
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB       11
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS      0x00007800u
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB       15
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS      0x001f8000u
+#define DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS     0x00200000u
+#define DMA_CH0_CTRL_TRIG_BUSY_BITS          0x01000000u
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->ctrl = incr ? c->ctrl | DMA_CH0_CTRL_TRIG_INCR_READ_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_INCR_READ_BITS;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->ctrl = incr ? c->ctrl | DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS) | (dreq << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB);
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) | (chain_to << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS) | ((uint) size << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+}
+
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ctrl = (c->ctrl & ~(DMA_CH0_CTRL_TRIG_RING_SIZE_BITS | DMA_CH0_CTRL_TRIG_RING_SEL_BITS)) |
+              (size_bits << DMA_CH0_CTRL_TRIG_RING_SIZE_LSB) | (write ? DMA_CH0_CTRL_TRIG_RING_SEL_BITS : 0);
+}
+
+static inline void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet) {
+    c->ctrl = irq_quiet ? c->ctrl | DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS;
+}
+
+static inline void channel_config_set_high_priority(dma_channel_config *c, bool high_priority) {
+    c->ctrl = high_priority ? c->ctrl | DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS;
+}
+
+static inline void channel_config_set_enable(dma_channel_config *c, bool enable) {
+    c->ctrl = enable ? c->ctrl | DMA_CH0_CTRL_TRIG_EN_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_EN_BITS;
+}
+
+static inline uint32_t channel_config_get_ctrl_value(const dma_channel_config *config) {
+    return config->ctrl;
+}
+
+// Enabled, 32-bit, read increment, unpaced, chained to itself (no chain)
+static inline dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = { 0 };
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_dreq(&c, DREQ_FORCE);
+    channel_config_set_chain_to(&c, channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_enable(&c, true);
+    return c;
+}
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_start_channel_mask(uint32_t chan_mask);
+bool dma_channel_is_busy(uint channel);
+void dma_irqn_set_channel_mask_enabled(uint irq_index, uint32_t channel_mask, bool enabled);
+
+#endif // NTSC_SIM_HARDWARE_DMA_H
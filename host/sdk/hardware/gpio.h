@@ -0,0 +1,17 @@
+#ifndef NTSC_SIM_HARDWARE_GPIO_H
+#define NTSC_SIM_HARDWARE_GPIO_H
+
+#include <pico.h>
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1, GPIO_FUNC_UART = 2, GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5, GPIO_FUNC_PIO0 = 6, GPIO_FUNC_PIO1 = 7,
+};
+#define GPIO_OUT 1
+#define GPIO_IN  0
+
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+
+#endif // NTSC_SIM_HARDWARE_GPIO_H
@@ -0,0 +1,16 @@
+#ifndef NTSC_SIM_HARDWARE_IRQ_H
+#define NTSC_SIM_HARDWARE_IRQ_H
+
+#include <pico.h>
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_set_priority(uint num, uint8_t hardware_priority);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif // NTSC_SIM_HARDWARE_IRQ_H
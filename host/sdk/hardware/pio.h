@@ -0,0 +1,75 @@
+#ifndef NTSC_SIM_HARDWARE_PIO_H
+#define NTSC_SIM_HARDWARE_PIO_H
+
+#include <pico.h>
+#include <hardware/gpio.h>
+#include <hardware/regs/dreq.h>
+
+// PIO blocks as plain registers, the TX FIFO is the DMA sink and the RX
+// FIFO holds the word sim_set_source() supplies next. Programs are only
+// encoded, never executed: samples are captured as the DMA writes them
+typedef struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t fstat;
+    volatile uint32_t fdebug;
+    volatile uint32_t flevel;
+    volatile uint32_t txf[4];
+    volatile uint32_t rxf[4];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+extern pio_hw_t *const pio0_hw;
+extern pio_hw_t *const pio1_hw;
+#define pio0 pio0_hw
+#define pio1 pio1_hw
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    uint32_t clkdiv;
+    uint32_t execctrl;
+    uint32_t shiftctrl;
+    uint32_t pinctrl;
+} pio_sm_config;
+
+enum pio_src_dest {
+    pio_pins = 0u, pio_x = 1u, pio_y = 2u, pio_null = 3u, pio_pindirs = 4u,
+    pio_exec_mov = 4u, pio_status = 5u, pio_pc = 5u, pio_isr = 6u, pio_osr = 7u, pio_exec_out = 7u,
+};
+
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX = 1, PIO_FIFO_JOIN_RX = 2 };
+
+// Instruction encodings, as in the SDK
+static inline uint pio_encode_delay(uint cycles) { return cycles << 8; }
+static inline uint pio_encode_sideset(uint sideset_bit_count, uint value) { return value << (13 - sideset_bit_count); }
+static inline uint pio_encode_jmp(uint addr) { return addr; }
+static inline uint pio_encode_out(enum pio_src_dest dest, uint count) { return 0x6000u | (dest & 7u) << 5 | (count & 31u); }
+static inline uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src) { return 0xa000u | (dest & 7u) << 5 | (src & 7u); }
+static inline uint pio_encode_nop(void) { return pio_encode_mov(pio_y, pio_y); }
+
+static inline uint pio_get_index(PIO pio) { return pio == pio1 ? 1 : 0; }
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return (pio == pio1 ? DREQ_PIO1_TX0 : DREQ_PIO0_TX0) + sm + (is_tx ? 0 : 4);
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_add_program_at_offset(PIO pio, const pio_program_t *program, uint offset);
+int pio_claim_unused_sm(PIO pio, bool required);
+pio_sm_config pio_get_default_sm_config(void);
+void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs);
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base);
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold);
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap);
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac);
+void pio_gpio_init(PIO pio, uint pin);
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+
+#endif // NTSC_SIM_HARDWARE_PIO_H
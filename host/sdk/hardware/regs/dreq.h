@@ -0,0 +1,22 @@
+#ifndef NTSC_SIM_HARDWARE_REGS_DREQ_H
+#define NTSC_SIM_HARDWARE_REGS_DREQ_H
+
+// Transfer request signals, only the video sinks (PIO TX FIFOs and PWM
+// wraps) and the PIO RX FIFOs fed by sim_set_source() are paced by the
+// model, other requests never fire
+#define DREQ_PIO0_TX0   0
+#define DREQ_PIO0_RX0   4
+#define DREQ_PIO1_TX0   8
+#define DREQ_PIO1_RX0   12
+#define DREQ_SPI0_TX    16
+#define DREQ_SPI0_RX    17
+#define DREQ_SPI1_TX    18
+#define DREQ_SPI1_RX    19
+#define DREQ_UART0_TX   20
+#define DREQ_UART0_RX   21
+#define DREQ_UART1_TX   22
+#define DREQ_UART1_RX   23
+#define DREQ_PWM_WRAP0  24
+#define DREQ_FORCE      0x3f
+
+#endif // NTSC_SIM_HARDWARE_REGS_DREQ_H
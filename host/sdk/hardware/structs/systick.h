@@ -0,0 +1,16 @@
+#ifndef NTSC_SIM_HARDWARE_STRUCTS_SYSTICK_H
+#define NTSC_SIM_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <pico.h>
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+// Not clocked, interrupt handlers take no simulated time
+extern systick_hw_t *systick_hw;
+
+#endif // NTSC_SIM_HARDWARE_STRUCTS_SYSTICK_H
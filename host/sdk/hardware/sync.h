@@ -0,0 +1,15 @@
+#ifndef NTSC_SIM_HARDWARE_SYNC_H
+#define NTSC_SIM_HARDWARE_SYNC_H
+
+#include <pico.h>
+
+// Hardware spinlocks, uncontended with one simulated core: a lock only
+// checks that it isn't taken twice
+typedef volatile uint32_t spin_lock_t;
+
+int spin_lock_claim_unused(bool required);
+spin_lock_t *spin_lock_instance(uint lock_num);
+uint32_t spin_lock_blocking(spin_lock_t *lock);
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq);
+
+#endif // NTSC_SIM_HARDWARE_SYNC_H
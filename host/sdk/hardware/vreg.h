@@ -0,0 +1,14 @@
+#ifndef NTSC_SIM_HARDWARE_VREG_H
+#define NTSC_SIM_HARDWARE_VREG_H
+
+#include <pico.h>
+
+enum vreg_voltage {
+    VREG_VOLTAGE_1_10 = 0b1011, VREG_VOLTAGE_1_15 = 0b1100, VREG_VOLTAGE_1_20 = 0b1101,
+    VREG_VOLTAGE_1_25 = 0b1110, VREG_VOLTAGE_1_30 = 0b1111,
+    VREG_VOLTAGE_DEFAULT = VREG_VOLTAGE_1_10,
+};
+
+void vreg_set_voltage(enum vreg_voltage voltage);
+
+#endif // NTSC_SIM_HARDWARE_VREG_H
@@ -0,0 +1,44 @@
+#ifndef NTSC_SIM_PICO_H
+#define NTSC_SIM_PICO_H
+
+// ------------------------------------------------------------
+// Host stand-in for the parts of the Pico SDK ntsc-tv-out.h uses.
+// Peripherals are modelled in ntsc-tv-sim-hw.c, everything else is a no-op
+// ------------------------------------------------------------
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define __time_critical_func(func_name) func_name
+#define __not_in_flash_func(func_name)  func_name
+#define __not_in_flash(group)
+#define __aligned(n) __attribute__ ((aligned (n)))
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#ifndef MIN
+#define MIN(a, b) ((b) > (a) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define PICO_DEFAULT_LED_PIN      25
+#define PICO_HIGHEST_IRQ_PRIORITY 0x00
+#define PICO_DEFAULT_IRQ_PRIORITY 0x80
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+#define hard_assert(condition) assert(condition)
+
+// One core, no events or interrupts between the simulator's steps
+static inline uint get_core_num(void) { return 0; }
+static inline void tight_loop_contents(void) {}
+static inline void __compiler_memory_barrier(void) { __asm__ volatile ("" ::: "memory"); }
+static inline void __dmb(void) { __compiler_memory_barrier(); }
+static inline void __sev(void) {}
+static inline void __wfe(void) {}
+static inline void __wfi(void) {}
+
+#endif // NTSC_SIM_PICO_H
@@ -0,0 +1,10 @@
+#ifndef NTSC_SIM_PICO_MULTICORE_H
+#define NTSC_SIM_PICO_MULTICORE_H
+
+#include <pico.h>
+
+// Core 1 is not simulated, launching it aborts
+void multicore_launch_core1(void (*entry)(void));
+void multicore_lockout_victim_init(void);
+
+#endif // NTSC_SIM_PICO_MULTICORE_H
@@ -0,0 +1,12 @@
+#ifndef NTSC_SIM_PICO_STDLIB_H
+#define NTSC_SIM_PICO_STDLIB_H
+
+#include <pico.h>
+#include <pico/time.h>
+#include <hardware/gpio.h>
+
+void set_sys_clock_pll(uint32_t vco_freq, uint post_div1, uint post_div2);
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+bool stdio_init_all(void);
+
+#endif // NTSC_SIM_PICO_STDLIB_H
@@ -0,0 +1,10 @@
+#ifndef NTSC_SIM_PICO_TIME_H
+#define NTSC_SIM_PICO_TIME_H
+
+#include <pico.h>
+
+// Host monotonic clock
+uint64_t time_us_64(void);
+void sleep_ms(uint32_t ms);
+
+#endif // NTSC_SIM_PICO_TIME_H
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include <hardware/clocks.h>
+#include "ntsc-tv-out.h"
+#include "ntsc-tv-checker.h"
+
+// ------------------------------------------------------------
+// On-target benchmark of the encoder and renderer kernels
+// Runs with the video clock of the timing profile (315 MHz with NTSC-M)
+// but without starting the video
+// output, so nothing but the benchmark competes for the core. Results
+// are printed over stdio (UART and USB) and repeated every few seconds
+// ------------------------------------------------------------
+
+// No reference numbers from hardware have been recorded yet, so there is
+// no regression check: compare the printed cycles between runs by hand
+typedef struct {
+    const char *name;
+    uint iterations;
+    void (*run)(uint iterations);
+} bench_t;
+
+static ntsc_sample_t bench_line[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+
+#if NTSC_HAS_FRAMEBUFFER && NTSC_PIXEL_BITS == 8 && NTSC_SAMPLES_PER_PIXEL == 2
+// The original per-pixel encoder, kept as the reference for ntsc_encode_pixels()
+static void __time_critical_func(bench_encode_reference)(ntsc_sample_t *output, const uint8_t *pixels) {
+    for (int pixel_index = 0; pixel_index < NTSC_FRAME_WIDTH; pixel_index++) {
+        const ntsc_sample_t *entry = ntsc_palette + pixels[pixel_index] * 4 + (pixel_index & 1 ? 2 : 0);
+        *output++ = entry[0];
+        *output++ = entry[1];
+    }
+}
+
+// One frame worth of active rows through the reference encoder
+static void bench_run_encode_reference(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        bench_encode_reference(bench_line + NTSC_ACTIVE_START, ntsc_display_buffer + i % NTSC_FRAME_HEIGHT * NTSC_VIRTUAL_ROW_BYTES);
+}
+#endif
+
+// One frame worth of active rows through the configured kernel
+static void bench_run_encode_active_line(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        ntsc_encode_active_line(bench_line, i % NTSC_FRAME_HEIGHT);
+}
+
+#if NTSC_DMA_ENGINE == NTSC_DMA_PINGPONG
+// Whole frames of scanlines, sync and blanking included
+static void bench_run_generate_scanline(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        ntsc_generate_scanline(i % NTSC_TOTAL_LINES);
+}
+#endif
+
+static void bench_run_set_color(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        ntsc_set_color((uint8_t) i, (uint8_t) (i * 3), (uint8_t) (i * 5), (uint8_t) (i * 7));
+}
+
+// Palette cycling over the 240 entries above the 16 fixed ones
+static void bench_run_rotate_palette(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        ntsc_rotate_palette(16, 240, 1);
+}
+
+#if NTSC_TILE_MODE
+static void bench_run_checker_tiles(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        checker_render_tiles(ntsc_tile_patterns, NTSC_TILE_COUNT, (int) i);
+}
+#elif NTSC_LINE_CALLBACK
+// The demo's line callback on its own, encode_active_line includes it
+static void bench_line_callback(const uint row, uint8_t *pixels) {
+    checker_render_line(pixels, (int) row, 0);
+}
+
+static void bench_run_checker_line(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        checker_render_line(ntsc_callback_line, (int) (i % NTSC_FRAME_HEIGHT), (int) i);
+}
+#elif NTSC_STREAM_INPUT
+// One frame worth of rows committed to the line ring and encoded from it
+static void bench_run_stream_line(const uint iterations) {
+    for (uint i = 0; i < iterations; i++) {
+        ntsc_stream_line_t *line = ntsc_stream_acquire();
+        line->row = (uint16_t) (i % NTSC_FRAME_HEIGHT);
+        ntsc_stream_commit();
+        ntsc_encode_active_line(bench_line, line->row);
+    }
+}
+
+static void bench_run_checker_line(const uint iterations) {
+    for (uint i = 0; i < iterations; i++)
+        checker_render_line(ntsc_stream_lines[0].pixels, (int) (i % NTSC_FRAME_HEIGHT), (int) i);
+}
+#else
+static void bench_run_checker_frame(const uint iterations) {
+    for (uint i = 0; i < iterations; i++) {
+#if NTSC_PIXEL_BITS != 8
+        checker_render_packed_frame((int) i);
+#else
+        checker_render_frame(ntsc_framebuffer, NTSC_VIRTUAL_WIDTH, NTSC_VIRTUAL_HEIGHT, (int) i);
+#endif
+    }
+}
+#endif
+
+static bench_t benches[] = {
+#if NTSC_HAS_FRAMEBUFFER && NTSC_PIXEL_BITS == 8 && NTSC_SAMPLES_PER_PIXEL == 2
+    { "encode_reference",    10 * NTSC_FRAME_HEIGHT, bench_run_encode_reference },
+#endif
+    { "encode_active_line",  10 * NTSC_FRAME_HEIGHT, bench_run_encode_active_line },
+#if NTSC_DMA_ENGINE == NTSC_DMA_PINGPONG
+    { "generate_scanline",   10 * NTSC_TOTAL_LINES,  bench_run_generate_scanline },
+#endif
+    { "set_color",           10 * 256,               bench_run_set_color },
+    { "rotate_palette",      100,                    bench_run_rotate_palette },
+#if NTSC_TILE_MODE
+    { "checker_tiles",       10,                     bench_run_checker_tiles },
+#elif NTSC_LINE_CALLBACK
+    { "checker_line",        10 * NTSC_FRAME_HEIGHT, bench_run_checker_line },
+#elif NTSC_STREAM_INPUT
+    { "stream_line",         10 * NTSC_FRAME_HEIGHT, bench_run_stream_line },
+    { "checker_line",        10 * NTSC_FRAME_HEIGHT, bench_run_checker_line },
+#else
+    { "checker_frame",       10,                     bench_run_checker_frame },
+#endif
+};
+
+static void bench_run_all() {
+    const uint32_t sys_mhz = clock_get_hz(clk_sys) / 1000000;
+
+    printf("\nntsc-tv-bench: %s, %s output, %lu MHz, %d-bit samples, %s engine, interp %d, tiles %d, callback %d, stream %d, %dbpp, %dx%d\n",
+           ntsc_timing_profile.name, NTSC_OUTPUT == NTSC_OUTPUT_DAC ? "DAC" : "PWM", (unsigned long) sys_mhz, NTSC_SAMPLE_BITS,
+           NTSC_DMA_ENGINE == NTSC_DMA_CONTROL_LIST ? "control list" : "ping-pong",
+           NTSC_USE_INTERP, NTSC_TILE_MODE, NTSC_LINE_CALLBACK, NTSC_STREAM_INPUT, NTSC_PIXEL_BITS, NTSC_FRAME_WIDTH, NTSC_FRAME_HEIGHT);
+    printf("%-20s %10s %12s\n", "bench", "iterations", "cycles/iter");
+
+    for (uint i = 0; i < count_of(benches); i++) {
+        const bench_t *bench = &benches[i];
+
+        const uint64_t start_us = time_us_64();
+        bench->run(bench->iterations);
+        const uint64_t elapsed_us = time_us_64() - start_us;
+        const uint32_t cycles = (uint32_t) (elapsed_us * sys_mhz / bench->iterations);
+
+        printf("%-20s %10u %12lu\n", bench->name, bench->iterations, (unsigned long) cycles);
+    }
+}
+
+void main() {
+    // Same clock as the video output, stdio follows the new peripheral clock
+    ntsc_init_clock();
+    stdio_init_all();
+
+    ntsc_build_line_templates();
+#if NTSC_PIXEL_BITS == 16
+    ntsc_build_rgb565_tables();
+#endif
+    bench_run_set_color(256);
+    init_wave_lut(8.0f, 0.09f, 0.11f, 0.12f);
+    // Realistic pixels for the encoders, which read the displayed page
+#if NTSC_TILE_MODE
+    for (uint i = 0; i < count_of(ntsc_tile_map); i++)
+        ntsc_tile_map[i] = (uint8_t) (i % NTSC_TILE_COUNT);
+    checker_render_tiles(ntsc_tile_patterns, NTSC_TILE_COUNT, 0);
+#elif NTSC_LINE_CALLBACK
+    ntsc_set_line_callback(bench_line_callback);
+#elif NTSC_STREAM_INPUT
+    for (uint i = 0; i < NTSC_STREAM_LINES; i++)
+        checker_render_line(ntsc_stream_lines[i].pixels, (int) i, 0);
+#elif NTSC_PIXEL_BITS != 8
+    checker_render_packed_frame(0);
+#else
+    checker_render_frame((uint8_t *) ntsc_display_buffer, NTSC_VIRTUAL_WIDTH, NTSC_VIRTUAL_HEIGHT, 0);
+#endif
+
+    while (1) {
+        bench_run_all();
+        sleep_ms(5000);
+    }
+}
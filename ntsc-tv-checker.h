@@ -0,0 +1,172 @@
+#ifndef NTSC_TV_CHECKER_H
+#define NTSC_TV_CHECKER_H
+
+#include <math.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------
+// Wavy checkerboard with 256-color gradient using LUT
+// Shared by the demo and the benchmark, included after ntsc-tv-out.h
+// ------------------------------------------------------------
+static int8_t wave_lut[256]; // amplitude-scaled sine (cos via +90° phase shift)
+static uint8_t step_x;       // phase step per pixel along x
+static uint8_t step_y;       // phase step per pixel along y
+static uint8_t tstep_1;      // phase step per frame for first wave
+static uint8_t tstep_2;      // phase step per frame for second wave (0.8x speed)
+
+// Build LUT and fixed-point steps (called once at startup)
+static void init_wave_lut(float amp, float fx, float fy, float t_speed) {
+    const float two_pi = 6.283185307179586f;
+    // Fill amplitude-scaled sine LUT
+    for (int i = 0; i < 256; ++i) {
+        float s = sinf((two_pi * i) / 256.0f);
+        int v = (int)lrintf(amp * s);
+        if (v < -128) v = -128;
+        if (v > 127) v = 127;
+        wave_lut[i] = (int8_t)v;
+    }
+    // Convert radians-per-pixel to phase steps in [0..255]
+    const float phase_scale = 256.0f / two_pi;
+    step_x  = (uint8_t)lrintf(fx       * phase_scale);    // ~4 for fx=0.09
+    step_y  = (uint8_t)lrintf(fy       * phase_scale);    // ~5 for fy=0.11
+    tstep_1 = (uint8_t)lrintf(t_speed  * phase_scale);    // ~5 for 0.12
+    tstep_2 = (uint8_t)lrintf((t_speed * 0.8f) * phase_scale); // ~4
+}
+
+static inline uint8_t checker_color_at(int x, int y, int frame) {
+    // Phase accumulation (mod 256 via uint8_t wrap)
+    const uint8_t phase_y = (uint8_t)(y * step_y + frame * tstep_1);
+    const uint8_t phase_x = (uint8_t)(x * step_x + frame * tstep_2 + 64); // cos = sin(+90°), 90° = 64 in 256-cycle
+
+    // Wavy warp via LUT
+    const int sx = x + wave_lut[phase_y];
+    const int sy = y + wave_lut[phase_x];
+
+    // Checker parity from warped coordinates
+    const int cx = sx / 16; // tile size 16
+    const int cy = sy / 16;
+    const int parity = (cx ^ cy) & 1;
+
+    // Full 256-color gradient across diagonal + time
+    const uint8_t base = (uint8_t)(sx + sy + (frame << 1));
+
+    // Opposite squares get shifted gradient to keep contrast while covering all 256 indices
+    return parity ? (uint8_t)(base ^ 0x80) : base;
+}
+
+// Signed division by 16 rounding toward zero, like / 16, as shifts
+static inline int checker_div16(int v) {
+    return (v + ((v >> 31) & 15)) >> 4;
+}
+
+// One pixel of checker_render_row(): sx is the warped x, phase_x the wave
+// phase of that pixel along x and frame_term the frame's gradient offset
+static inline uint32_t checker_row_pixel(int sx, int y, uint8_t phase_x, int frame_term) {
+    const int sy = y + wave_lut[phase_x];
+    const uint8_t base = (uint8_t) (sx + sy + frame_term);
+    return (checker_div16(sx) ^ checker_div16(sy)) & 1 ? base ^ 0x80 : base;
+}
+
+// Render row y of the effect, same pixels as checker_color_at(): the y
+// phase and warp are hoisted out of the row, the x phase steps by step_x
+// per pixel and 4 pixels go out per 32-bit store. row must be 4-byte
+// aligned and width a multiple of 4
+static void __time_critical_func(checker_render_row)(uint8_t *row, int width, int y, int frame) {
+    const int warp_x = wave_lut[(uint8_t) (y * step_y + frame * tstep_1)];
+    const int frame_term = frame << 1;
+    uint8_t phase_x = (uint8_t) (frame * tstep_2 + 64);
+
+    uint32_t *output = (uint32_t *) row;
+    for (int sx = warp_x; sx < warp_x + width; sx += 4) {
+        uint32_t word = checker_row_pixel(sx, y, phase_x, frame_term);
+        word |= checker_row_pixel(sx + 1, y, (uint8_t) (phase_x + step_x), frame_term) << 8;
+        word |= checker_row_pixel(sx + 2, y, (uint8_t) (phase_x + 2 * step_x), frame_term) << 16;
+        word |= checker_row_pixel(sx + 3, y, (uint8_t) (phase_x + 3 * step_x), frame_term) << 24;
+        phase_x += 4 * step_x;
+        *output++ = word;
+    }
+}
+
+// Render rows y0 to y1 - 1 of the effect
+static void checker_render_rows(uint8_t *framebuffer, int width, int y0, int y1, int frame) {
+    for (int y = y0; y < y1; y++) {
+        uint8_t *row = &framebuffer[y * width];
+        if (width % 4 == 0) {
+            checker_render_row(row, width, y, frame);
+            continue;
+        }
+        for (int x = 0; x < width; x++) {
+            row[x] = checker_color_at(x, y, frame);
+        }
+    }
+}
+
+// Render one full frame of the effect
+static void checker_render_frame(uint8_t *framebuffer, int width, int height, int frame) {
+    checker_render_rows(framebuffer, width, 0, height, frame);
+}
+
+#if defined(NTSC_PIXEL_BITS) && NTSC_PIXEL_BITS != 8
+// Effect color in the framebuffer's pixel format: the top NTSC_PIXEL_BITS
+// bits of the color index, or the index read as RGB332 at 16bpp
+static inline uint16_t checker_pixel(uint8_t color) {
+#if NTSC_PIXEL_BITS == 16
+    return NTSC_RGB565((color >> 5) * 255 / 7, (color >> 2 & 7) * 255 / 7, (color & 3) * 255 / 3);
+#else
+    return color >> (8 - NTSC_PIXEL_BITS);
+#endif
+}
+#endif
+
+#if defined(NTSC_PIXEL_BITS) && NTSC_PIXEL_BITS != 8 && NTSC_HAS_FRAMEBUFFER
+// Render rows y0 to y1 - 1 of the effect into a packed or RGB565 ntsc_framebuffer
+static void checker_render_packed_rows(int y0, int y1, int frame) {
+    for (int y = y0; y < y1; y++) {
+        for (int x = 0; x < NTSC_VIRTUAL_WIDTH; x++) {
+            ntsc_put_pixel(x, y, checker_pixel(checker_color_at(x, y, frame)));
+        }
+    }
+}
+
+// Render one full frame of the effect into a packed or RGB565 ntsc_framebuffer
+static void checker_render_packed_frame(int frame) {
+    checker_render_packed_rows(0, NTSC_VIRTUAL_HEIGHT, frame);
+}
+#endif
+
+#if defined(NTSC_HAS_FRAMEBUFFER) && !NTSC_HAS_FRAMEBUFFER && !NTSC_TILE_MODE
+// Render row y of the effect into a line callback's or a stream line's
+// pixel buffer, in the NTSC_PIXEL_BITS format
+static void __time_critical_func(checker_render_line)(uint8_t *pixels, int y, int frame) {
+#if NTSC_PIXEL_BITS == 8
+    checker_render_row(pixels, NTSC_FRAME_WIDTH, y, frame);
+#elif NTSC_PIXEL_BITS == 16
+    for (int x = 0; x < NTSC_FRAME_WIDTH; x++)
+        ((uint16_t *) pixels)[x] = checker_pixel(checker_color_at(x, y, frame));
+#else
+    int x = 0;
+    for (int byte_index = 0; byte_index < NTSC_FRAME_ROW_BYTES; byte_index++) {
+        uint8_t byte = 0;
+        for (int shift = 0; shift < 8; shift += NTSC_PIXEL_BITS)
+            byte |= checker_pixel(checker_color_at(x++, y, frame)) << shift;
+        pixels[byte_index] = byte;
+    }
+#endif
+}
+#endif
+
+// Render the effect into a tile pattern table: tile t shows the 8x8 block
+// at column t % 16, row t / 16 of the full-frame effect
+static void checker_render_tiles(uint8_t (*patterns)[64], int tile_count, int frame) {
+    for (int t = 0; t < tile_count; t++) {
+        const int x0 = t % 16 * 8;
+        const int y0 = t / 16 * 8;
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) {
+                patterns[t][y * 8 + x] = checker_color_at(x0 + x, y0 + y, frame);
+            }
+        }
+    }
+}
+
+#endif // NTSC_TV_CHECKER_H
@@ -26,307 +26,2949 @@ caused by using this program.
 
 #include <hardware/dma.h>
 #include <hardware/pwm.h>
+#include <hardware/sync.h>
 #include <hardware/vreg.h>
+#include <pico/multicore.h>
+#include <string.h>
 
 /* ===========================================================================
  * NTSC Video Format Constants
  * =========================================================================== */
 
+// Output stage
+//  NTSC_OUTPUT_PWM: one pin, the sample level is the duty cycle of a PWM
+//                   (or PIO PWM) period, filtered by an RC low-pass into the
+//                   composite signal. Needs a fast clock, 315 MHz with NTSC-M
+//  NTSC_OUTPUT_DAC: NTSC_DAC_BITS pins from NTSC_DAC_PIN_BASE up, a PIO state
+//                   machine writes each sample as a binary code to an R-2R or
+//                   binary weighted resistor ladder. The sample rate no longer
+//                   has to be 11 PWM periods, NTSC-M runs at 157.5 MHz, and
+//                   the levels are 2^(NTSC_DAC_BITS - 4) times finer
+#define NTSC_OUTPUT_PWM        0
+#define NTSC_OUTPUT_DAC        1
+
+#ifndef NTSC_OUTPUT
+#define NTSC_OUTPUT            NTSC_OUTPUT_PWM
+#endif
+
+// Video standard
+//  NTSC_STANDARD_NTSC_M:  NTSC, 525 lines at 60 Hz, 3.579545 MHz subcarrier
+//  NTSC_STANDARD_PAL_M:   PAL color on the NTSC-M line timing, 3.575611 MHz
+//                         subcarrier (Brazil)
+//  NTSC_STANDARD_PAL_60:  PAL color on 525 lines at 60 Hz, 4.433619 MHz
+//                         subcarrier, decoded by most PAL TVs
+//  NTSC_STANDARD_PAL_BG:  PAL, 625 lines at 50 Hz, 4.433619 MHz subcarrier,
+//                         288 visible lines per field
+// PAL inverts the (R-Y) component and swings the color burst by 90° on
+// every other line, so PAL standards need NTSC_LINE_REPEAT 1 (a repeated
+// line would keep its phase) and cannot use NTSC_ARTIFACT_COLOR
+#define NTSC_STANDARD_NTSC_M   0
+#define NTSC_STANDARD_PAL_M    1
+#define NTSC_STANDARD_PAL_60   2
+#define NTSC_STANDARD_PAL_BG   3
+
+#ifndef NTSC_STANDARD
+#define NTSC_STANDARD          NTSC_STANDARD_NTSC_M
+#endif
+#define NTSC_PAL               (NTSC_STANDARD != NTSC_STANDARD_NTSC_M)
+
+// Timing profile of each standard, fixed at compile time
+// The system clock comes from the PLL (12 MHz crystal, VCO and two post
+// dividers), the output runs at the system clock over NTSC_CLOCK_DIVIDER and
+// one sample lasts NTSC_SAMPLE_CYCLES output cycles, which gives PWM levels
+// 0..NTSC_SAMPLE_CYCLES and 4 samples per subcarrier cycle
+// Scanlines are a whole number of subcarrier cycles and of 4-sample words,
+// so every line starts at subcarrier phase 0
+#if NTSC_STANDARD == NTSC_STANDARD_NTSC_M
+// 1260 MHz / 4 = 315 MHz, 315 MHz / 22 = 14.318182 MHz: exactly 4x the
+// 315/88 MHz subcarrier. The DAC has no PWM period to fit, it runs the PIO
+// off 1260 MHz / 8 = 157.5 MHz at stock voltage, 157.5 MHz / 11 is the same
+// sample rate
+#define NTSC_STANDARD_NAME     "NTSC-M"
+#define NTSC_PLL_VCO_HZ        1260000000
+#if NTSC_OUTPUT == NTSC_OUTPUT_DAC
+#define NTSC_PLL_POST_DIV1     4
+#define NTSC_PLL_POST_DIV2     2
+#define NTSC_CORE_VOLTAGE      VREG_VOLTAGE_DEFAULT
+#define NTSC_CLOCK_DIVIDER     1
+#else
+#define NTSC_PLL_POST_DIV1     2
+#define NTSC_PLL_POST_DIV2     2
+#define NTSC_CORE_VOLTAGE      VREG_VOLTAGE_1_30
+#define NTSC_CLOCK_DIVIDER     2
+#endif
+#define NTSC_SAMPLE_CYCLES     11
+#define NTSC_SUBCARRIER_HZ     3579545
+#define NTSC_SAMPLES_PER_LINE  908   // 227 * 4 samples per scanline, 63.4 us
+#define NTSC_FIELD_LINES       262   // Scanlines from one field's start to the next's, the first field only with interlace
+#define NTSC_VBLANK_LINES      20    // Vertical sync and top blanking lines before the visible lines
+#define NTSC_VISIBLE_LINES     240   // Lines available for the picture in each field
+#define NTSC_HSYNC_WIDTH       68    // Horizontal sync width in samples (~4.7μs)
+#define NTSC_BURST_START       (NTSC_HSYNC_WIDTH + 8)  // Color burst start in samples
+#define NTSC_BURST_CYCLES      9     // Color burst length in subcarrier cycles
+#define NTSC_ACTIVE_CENTER     (NTSC_BURST_START + NTSC_BURST_CYCLES * 4 + 60 + 320)  // Center of the active video window
+#elif NTSC_STANDARD == NTSC_STANDARD_PAL_M
+// 1416 MHz / 9 = 157.333 MHz, / 11 = 14.303030 MHz: 4x the subcarrier +41 ppm
+#define NTSC_STANDARD_NAME     "PAL-M"
+#define NTSC_PLL_VCO_HZ        1416000000
+#define NTSC_PLL_POST_DIV1     3
+#define NTSC_PLL_POST_DIV2     3
+#define NTSC_CORE_VOLTAGE      VREG_VOLTAGE_DEFAULT
+#define NTSC_CLOCK_DIVIDER     1
+#define NTSC_SAMPLE_CYCLES     11
+#define NTSC_SUBCARRIER_HZ     3575611
+#define NTSC_SAMPLES_PER_LINE  908   // 227 * 4 samples per scanline, 63.5 us
+#define NTSC_FIELD_LINES       262
+#define NTSC_VBLANK_LINES      20
+#define NTSC_VISIBLE_LINES     240
+#define NTSC_HSYNC_WIDTH       68
+#define NTSC_BURST_START       (NTSC_HSYNC_WIDTH + 8)
+#define NTSC_BURST_CYCLES      9
+#define NTSC_ACTIVE_CENTER     (NTSC_BURST_START + NTSC_BURST_CYCLES * 4 + 60 + 320)
+#elif NTSC_STANDARD == NTSC_STANDARD_PAL_60 || NTSC_STANDARD == NTSC_STANDARD_PAL_BG
+// 1596 MHz / 9 = 177.333 MHz, / 10 = 17.733333 MHz: 4x the subcarrier -64 ppm
+// At 10 cycles per sample the PWM levels only go up to 10, and each level
+// is 10% higher in volts than with the 11-cycle samples
+#define NTSC_PLL_VCO_HZ        1596000000
+#define NTSC_PLL_POST_DIV1     3
+#define NTSC_PLL_POST_DIV2     3
+#define NTSC_CORE_VOLTAGE      VREG_VOLTAGE_DEFAULT
+#define NTSC_CLOCK_DIVIDER     1
+#define NTSC_SAMPLE_CYCLES     10
+#define NTSC_SUBCARRIER_HZ     4433619
+#if NTSC_STANDARD == NTSC_STANDARD_PAL_60
+#define NTSC_STANDARD_NAME     "PAL-60"
+#define NTSC_SAMPLES_PER_LINE  1128  // 282 * 4 samples per scanline, 63.6 us
+#define NTSC_FIELD_LINES       262
+#define NTSC_VBLANK_LINES      20
+#define NTSC_VISIBLE_LINES     240
+#else
+#define NTSC_STANDARD_NAME     "PAL-B/G"
+#define NTSC_SAMPLES_PER_LINE  1136  // 284 * 4 samples per scanline, 64.1 us
+#define NTSC_FIELD_LINES       312
+#define NTSC_VBLANK_LINES      22
+#define NTSC_VISIBLE_LINES     288
+#endif
+#define NTSC_HSYNC_WIDTH       84    // ~4.7 us
+#define NTSC_BURST_START       (NTSC_HSYNC_WIDTH + 16)  // ~0.9 us breezeway
+#define NTSC_BURST_CYCLES      10
+#define NTSC_ACTIVE_CENTER     610   // 34.4 us after the sync, like the NTSC-M picture
+#else
+#error "NTSC_STANDARD must be one of the NTSC_STANDARD_* values"
+#endif
+
+// Timing profile in use, for the clock setup and for applications
+typedef struct {
+    const char *name;               // Video standard, e.g. "PAL-B/G"
+    uint32_t pll_vco_hz;            // System PLL VCO frequency
+    uint8_t pll_post_div1;          // System PLL post dividers, the system clock
+    uint8_t pll_post_div2;          // is pll_vco_hz / (pll_post_div1 * pll_post_div2)
+    enum vreg_voltage core_voltage; // Core voltage the system clock needs
+    uint8_t clock_divider;          // System clock cycles per output cycle (PWM or PIO)
+    uint8_t sample_cycles;          // Output cycles per sample, also the highest PWM level
+    uint32_t subcarrier_hz;         // Nominal color subcarrier
+    uint16_t samples_per_line;      // Samples per scanline, 4 per subcarrier cycle
+    uint16_t field_lines;           // Scanlines per field (of the first field with interlace)
+    uint16_t visible_lines;         // Lines available for the picture in each field
+} ntsc_timing_profile_t;
+
+static const ntsc_timing_profile_t ntsc_timing_profile = {
+    .name = NTSC_STANDARD_NAME,
+    .pll_vco_hz = NTSC_PLL_VCO_HZ,
+    .pll_post_div1 = NTSC_PLL_POST_DIV1,
+    .pll_post_div2 = NTSC_PLL_POST_DIV2,
+    .core_voltage = NTSC_CORE_VOLTAGE,
+    .clock_divider = NTSC_CLOCK_DIVIDER,
+    .sample_cycles = NTSC_SAMPLE_CYCLES,
+    .subcarrier_hz = NTSC_SUBCARRIER_HZ,
+    .samples_per_line = NTSC_SAMPLES_PER_LINE,
+    .field_lines = NTSC_FIELD_LINES,
+    .visible_lines = NTSC_VISIBLE_LINES,
+};
+
 // Frame dimensions
+// The width must be a multiple of 4 (the encoder reads 4 pixels at a time),
+// up to 320 pixels are sent with 2 samples per pixel (e.g. 256, 280, 320),
+// wider frames up to 640 pixels with 1 sample per pixel: each pixel is then
+// one sample at its own subcarrier phase, full luma detail but color only
+// resolved over 4 pixels
+// The picture is centered horizontally on the 320 pixel window
+// Each framebuffer row is shown on NTSC_LINE_REPEAT consecutive scanlines
+// (1, 2 or 3), the height defaults to the visible lines (240, 288 with
+// PAL-B/G) divided by it
+// The height may be reduced (e.g. to fit two pages with NTSC_DOUBLE_BUFFER),
+// the picture is then centered vertically inside the visible lines
+#ifndef NTSC_FRAME_WIDTH
 #define NTSC_FRAME_WIDTH    320
-#define NTSC_FRAME_HEIGHT   240
+#endif
+#ifndef NTSC_LINE_REPEAT
+#define NTSC_LINE_REPEAT    1
+#endif
+
+// Scan mode
+//  0: progressive 240p, 262 lines per frame, every frame sends all rows
+//  1: interlaced 480i, 525 lines per frame in two fields of 262.5 lines
+//     with half-line equalizing and serration pulses, the first field sends
+//     the odd rows and the second field, half a line higher on screen, the
+//     even rows; the height defaults to 480 and NTSC_LINE_REPEAT must be 1
+#ifndef NTSC_INTERLACE
+#define NTSC_INTERLACE      0
+#endif
+#define NTSC_FIELDS         (NTSC_INTERLACE ? 2 : 1)
+
+#ifndef NTSC_FRAME_HEIGHT
+#define NTSC_FRAME_HEIGHT   (NTSC_VISIBLE_LINES * NTSC_FIELDS / NTSC_LINE_REPEAT)
+#endif
 
 // NTSC timing parameters
-#define NTSC_SAMPLES_PER_LINE  908   // 227 * 4 samples per scanline
-#define NTSC_TOTAL_LINES       262   // Total scanlines in NTSC frame
-#define NTSC_VSYNC_LINES       10    // Vertical sync pulse lines
-#define NTSC_VBLANK_TOP        26    // Top blanking interval lines
-#define NTSC_HSYNC_WIDTH       68    // Horizontal sync width in samples (~4.7μs)
-#define NTSC_ACTIVE_START      (NTSC_HSYNC_WIDTH + 8 + 9 * 4 + 60)  // Start of active video
+#define NTSC_TOTAL_LINES       (NTSC_FIELD_LINES * NTSC_FIELDS + NTSC_INTERLACE)  // Total scanlines in NTSC frame
+#define NTSC_VSYNC_LINES       (10 - NTSC_INTERLACE)  // Vertical sync lines (of the first field with interlace)
+#define NTSC_VBLANK_TOP        (NTSC_VBLANK_LINES - NTSC_VSYNC_LINES)  // Top blanking interval lines
+#define NTSC_EQUALIZING_WIDTH  (NTSC_HSYNC_WIDTH / 2)  // Equalizing pulse width in samples (~2.3μs)
+
+// Active video window, centered on NTSC_ACTIVE_CENTER, which is the middle
+// of the 640 samples of the 320 pixel mode that start 60 samples after the
+// NTSC color burst
+#define NTSC_SAMPLES_PER_PIXEL (NTSC_FRAME_WIDTH > 320 ? 1 : 2)
+#define NTSC_ACTIVE_SAMPLES    (NTSC_FRAME_WIDTH * NTSC_SAMPLES_PER_PIXEL)
+#define NTSC_ACTIVE_START      ((NTSC_ACTIVE_CENTER - NTSC_ACTIVE_SAMPLES / 2) & ~3)  // Start of active video
+
+// Framebuffer rows sent in each field, and the framebuffer row sent as row
+// `field_row` of field `field`: the fields interleave, the second field's
+// lines fall half a line above the first field's
+#define NTSC_FIELD_ROWS        (NTSC_FRAME_HEIGHT / NTSC_FIELDS)
+#define NTSC_FIELD_ROW(field, field_row) ((field_row) * NTSC_FIELDS + NTSC_FIELDS - 1 - (field))
+
+// First and one-past-last scanline carrying framebuffer rows, counted from
+// the start of the field
+#define NTSC_ACTIVE_LINES      (NTSC_FIELD_ROWS * NTSC_LINE_REPEAT)
+#define NTSC_ACTIVE_FIRST_LINE (NTSC_VSYNC_LINES + NTSC_VBLANK_TOP + (NTSC_VISIBLE_LINES - NTSC_ACTIVE_LINES) / 2)
+#define NTSC_ACTIVE_END_LINE   (NTSC_ACTIVE_FIRST_LINE + NTSC_ACTIVE_LINES)
+
+// Active video plus the two blanking lines after it must fit in one field,
+// otherwise the end-of-frame point (vsync, page flip) is never reached
+_Static_assert(NTSC_LINE_REPEAT >= 1 && NTSC_LINE_REPEAT <= 3, "NTSC_LINE_REPEAT must be 1, 2 or 3");
+#if NTSC_INTERLACE && NTSC_LINE_REPEAT != 1
+#error "NTSC_INTERLACE needs NTSC_LINE_REPEAT 1, the fields already split the rows"
+#endif
+#if NTSC_PAL && NTSC_LINE_REPEAT != 1
+#error "PAL standards need NTSC_LINE_REPEAT 1, every line alternates its phase"
+#endif
+// The V-switch follows the line number, which the odd 525/625 line frame
+// would break at every wrap, and the interlaced sync is NTSC's 6/6/6 pulses
+#if NTSC_PAL && NTSC_INTERLACE
+#error "NTSC_INTERLACE is NTSC-M only, PAL standards can't be interlaced"
+#endif
+// PAL lines alternate by absolute line number, across fields too
+_Static_assert(!NTSC_PAL || NTSC_FIELD_LINES % 2 == 0, "PAL needs an even NTSC_FIELD_LINES");
+_Static_assert(NTSC_FRAME_HEIGHT % NTSC_FIELDS == 0, "NTSC_FRAME_HEIGHT must be even with NTSC_INTERLACE");
+_Static_assert(NTSC_ACTIVE_LINES <= NTSC_VISIBLE_LINES, "NTSC_FRAME_HEIGHT * NTSC_LINE_REPEAT exceeds visible lines");
+_Static_assert(NTSC_FRAME_WIDTH % 4 == 0, "NTSC_FRAME_WIDTH must be a multiple of 4");
+_Static_assert(NTSC_FRAME_WIDTH <= 640, "NTSC_FRAME_WIDTH exceeds the active video window");
+_Static_assert(NTSC_ACTIVE_END_LINE + 2 <= NTSC_FIELD_LINES, "Active video does not fit in NTSC frame");
+
+// NTSC composite video signal levels (0-7 range for 3-bit PWM)
+#define NTSC_LEVEL_SYNC          NTSC_LEVEL(0)  // Sync pulse level (lowest)
+#define NTSC_LEVEL_BLANK         NTSC_LEVEL(2)  // Blanking/black level
+#define NTSC_LEVEL_BLACK         NTSC_LEVEL(2)  // Black level (same as blanking)
+#define NTSC_LEVEL_BURST_LOW     NTSC_LEVEL(1)  // Color burst low level
+#define NTSC_LEVEL_BURST_HIGH    NTSC_LEVEL(3)  // Color burst high level
+
+/* ===========================================================================
+ * Hardware Pin Configuration
+ * =========================================================================== */
+
+// Pin for NTSC composite video signal output via PWM
+#ifndef NTSC_PIN_OUTPUT
+#define NTSC_PIN_OUTPUT 27
+#endif
+
+// Resistor ladder DAC (NTSC_OUTPUT_DAC): NTSC_DAC_BITS consecutive pins,
+// least significant bit on NTSC_DAC_PIN_BASE, 4 to 8 bits
+#ifndef NTSC_DAC_PIN_BASE
+#define NTSC_DAC_PIN_BASE 8
+#endif
+#ifndef NTSC_DAC_BITS
+#define NTSC_DAC_BITS 6
+#endif
+
+#if NTSC_OUTPUT == NTSC_OUTPUT_DAC
+_Static_assert(NTSC_DAC_BITS >= 4 && NTSC_DAC_BITS <= 8, "NTSC_DAC_BITS must be 4 to 8");
+#elif NTSC_OUTPUT != NTSC_OUTPUT_PWM
+#error "NTSC_OUTPUT must be NTSC_OUTPUT_PWM or NTSC_OUTPUT_DAC"
+#endif
+
+// Output levels per PWM level and the highest output level. The signal
+// levels are defined on the PWM scale (0..11 with NTSC-M), the DAC codes
+// 2^NTSC_LEVEL_SHIFT times finer with the same volts per PWM level, which
+// leaves the codes above 11 PWM levels as headroom
+#if NTSC_OUTPUT == NTSC_OUTPUT_DAC
+#define NTSC_LEVEL_SHIFT (NTSC_DAC_BITS - 4)
+#define NTSC_LEVEL_MAX   ((1 << NTSC_DAC_BITS) - 1)
+#else
+#define NTSC_LEVEL_SHIFT 0
+#define NTSC_LEVEL_MAX   NTSC_SAMPLE_CYCLES
+#endif
+
+// Output level of a PWM scale level
+#define NTSC_LEVEL(level) ((level) * (1 << NTSC_LEVEL_SHIFT))
+
+/* ===========================================================================
+ * Sample Format
+ * =========================================================================== */
+
+// Output cycles per sample (NTSC_SAMPLE_CYCLES, see the timing profile) set
+// the PWM levels: 0..11 (0% to 100% duty) with NTSC-M
+
+// NTSC_OUTPUT_DAC writes one byte per sample to the PIO, 8-bit samples only
+
+// Scanline sample format
+//  16: one halfword per sample, DMA'd into the PWM compare register
+//   8: one byte per sample, packed 4 per 32-bit DMA transfer into a PIO state
+//      machine that generates the same PWM waveform on NTSC_PIN_OUTPUT.
+//      IO registers replicate narrow writes across all byte lanes, so bytes
+//      cannot be DMA'd into the PWM compare register directly
+#ifndef NTSC_SAMPLE_BITS
+#if NTSC_OUTPUT == NTSC_OUTPUT_DAC
+#define NTSC_SAMPLE_BITS 8
+#else
+#define NTSC_SAMPLE_BITS 16
+#endif
+#endif
+
+#if NTSC_OUTPUT == NTSC_OUTPUT_DAC && NTSC_SAMPLE_BITS != 8
+#error "NTSC_OUTPUT_DAC needs NTSC_SAMPLE_BITS=8"
+#endif
+
+#if NTSC_SAMPLE_BITS == 8
+#include <hardware/pio.h>
+
+// PIO block running the PWM waveform or DAC program
+#ifndef NTSC_PIO
+#define NTSC_PIO pio0
+#endif
+
+typedef uint8_t ntsc_sample_t;
+#define NTSC_SAMPLES_PER_TRANSFER 4
+#define NTSC_DMA_TRANSFER_SIZE    DMA_SIZE_32
+
+#if NTSC_OUTPUT == NTSC_OUTPUT_DAC
+// Samples are the DAC code
+#define NTSC_SAMPLE(level)        (level)
+#else
+// Samples are jump targets into the PIO waveform table (see ntsc_init_output)
+#define NTSC_SAMPLE(level)        ((level) ? 2 * (level) - 1 : 0)
+#endif
+#elif NTSC_SAMPLE_BITS == 16
+typedef uint16_t ntsc_sample_t;
+#define NTSC_SAMPLES_PER_TRANSFER 1
+#define NTSC_DMA_TRANSFER_SIZE    DMA_SIZE_16
+
+// Samples are the PWM compare value
+#define NTSC_SAMPLE(level)        (level)
+#else
+#error "NTSC_SAMPLE_BITS must be 8 or 16"
+#endif
+
+// Video source
+//  0: 8bpp framebuffer of NTSC_FRAME_WIDTH x NTSC_FRAME_HEIGHT pixels
+//  1: Tile map of 8x8 pixel tiles, expanded line by line from the tile
+//     pattern table while the frame is scanned out
+#ifndef NTSC_TILE_MODE
+#define NTSC_TILE_MODE 0
+#endif
+
+// Line callback video source
+//  0: Rows are read from the framebuffer (or the tile map)
+//  1: No framebuffer, the callback set with ntsc_set_line_callback() fills
+//     every row into a line buffer right before the video core encodes it
+#ifndef NTSC_LINE_CALLBACK
+#define NTSC_LINE_CALLBACK 0
+#endif
+
+#if NTSC_LINE_CALLBACK && NTSC_TILE_MODE
+#error "NTSC_LINE_CALLBACK replaces the framebuffer, it can't be used with NTSC_TILE_MODE"
+#endif
+
+// Streaming video source
+//  0: Rows are read from the framebuffer (or the tile map, or the callback)
+//  1: No framebuffer, rows arrive in a ring of NTSC_STREAM_LINES line
+//     buffers, filled by the application or straight by DMA from a
+//     peripheral (see ntsc_stream_start_dma()), and are encoded in place
+#ifndef NTSC_STREAM_INPUT
+#define NTSC_STREAM_INPUT 0
+#endif
+
+// Line buffers in the stream ring, a power of two. One holds the row on
+// air for repeats, the others are the slack between producer and video core
+#ifndef NTSC_STREAM_LINES
+#define NTSC_STREAM_LINES 8
+#endif
+
+#if NTSC_STREAM_INPUT && (NTSC_TILE_MODE || NTSC_LINE_CALLBACK)
+#error "NTSC_STREAM_INPUT replaces the framebuffer, it can't be used with NTSC_TILE_MODE or NTSC_LINE_CALLBACK"
+#endif
+
+// Rows are read from ntsc_framebuffer
+#define NTSC_HAS_FRAMEBUFFER (!NTSC_TILE_MODE && !NTSC_LINE_CALLBACK && !NTSC_STREAM_INPUT)
+
+// Framebuffer pixel format, bits per pixel
+//  8: 256 colors, one byte per pixel
+//  4, 2, 1: 16, 4 or 2 colors (palette entries 0..2^bits-1), pixels packed
+//     into bytes starting from the least significant bits, so pixel x of a
+//     row is bits (x * NTSC_PIXEL_BITS) % 8 and up of byte x * NTSC_PIXEL_BITS / 8
+// 16: RGB565 true color, one halfword per pixel, no palette
+// For RGB332 true color use 8bpp with ntsc_set_rgb332_palette()
+#ifndef NTSC_PIXEL_BITS
+#define NTSC_PIXEL_BITS 8
+#endif
+
+#if NTSC_PIXEL_BITS != 16 && NTSC_PIXEL_BITS != 8 && NTSC_PIXEL_BITS != 4 && NTSC_PIXEL_BITS != 2 && NTSC_PIXEL_BITS != 1
+#error "NTSC_PIXEL_BITS must be 16, 8, 4, 2 or 1"
+#endif
+
+// Pack 8-bit color components into RGB332 and RGB565 pixels
+#define NTSC_RGB332(red, green, blue) ((uint8_t) (((red) & 0xE0) | ((green) >> 3 & 0x1C) | ((blue) >> 6)))
+#define NTSC_RGB565(red, green, blue) ((uint16_t) (((red) & 0xF8) << 8 | ((green) & 0xFC) << 3 | (blue) >> 3))
+#if NTSC_TILE_MODE && NTSC_PIXEL_BITS != 8
+#error "NTSC_TILE_MODE uses 8bpp tiles, it can't be used with NTSC_PIXEL_BITS"
+#endif
+
+// Artifact color (1bpp only)
+//  0: 1bpp pixels are palette entries 0 and 1
+//  1: 1bpp pixels are raw samples, a set bit sends NTSC_ARTIFACT_WHITE and a
+//     clear bit NTSC_ARTIFACT_BLACK, both PWM scale levels. With NTSC_FRAME_WIDTH 640 each pixel is
+//     one sample, so every 4 pixels starting at a multiple of 4 span one
+//     subcarrier cycle and their bit pattern decodes as a color on the TV
+#ifndef NTSC_ARTIFACT_COLOR
+#define NTSC_ARTIFACT_COLOR 0
+#endif
+#ifndef NTSC_ARTIFACT_BLACK
+#define NTSC_ARTIFACT_BLACK 2
+#endif
+#ifndef NTSC_ARTIFACT_WHITE
+#define NTSC_ARTIFACT_WHITE 9
+#endif
+
+#if NTSC_ARTIFACT_COLOR && NTSC_PIXEL_BITS != 1
+#error "NTSC_ARTIFACT_COLOR needs NTSC_PIXEL_BITS=1"
+#endif
+#if NTSC_ARTIFACT_COLOR && NTSC_PAL
+#error "NTSC_ARTIFACT_COLOR needs NTSC_STANDARD_NTSC_M, raw samples don't follow the PAL line phase"
+#endif
+
+// Framebuffer row size in bytes, rows are read 32 bits at a time
+#define NTSC_FRAME_ROW_BYTES (NTSC_FRAME_WIDTH * NTSC_PIXEL_BITS / 8)
+_Static_assert(NTSC_FRAME_ROW_BYTES % 4 == 0, "Framebuffer rows must be a whole number of words");
+
+// Framebuffer size in pixels, the frame shows a NTSC_FRAME_WIDTH x
+// NTSC_FRAME_HEIGHT viewport into it (see NTSC_SCROLL)
+#ifndef NTSC_VIRTUAL_WIDTH
+#define NTSC_VIRTUAL_WIDTH   NTSC_FRAME_WIDTH
+#endif
+#ifndef NTSC_VIRTUAL_HEIGHT
+#define NTSC_VIRTUAL_HEIGHT  NTSC_FRAME_HEIGHT
+#endif
+
+// Framebuffer stride in bytes
+#define NTSC_VIRTUAL_ROW_BYTES (NTSC_VIRTUAL_WIDTH * NTSC_PIXEL_BITS / 8)
+_Static_assert(NTSC_VIRTUAL_WIDTH >= NTSC_FRAME_WIDTH && NTSC_VIRTUAL_HEIGHT >= NTSC_FRAME_HEIGHT,
+               "The virtual framebuffer must cover the frame");
+_Static_assert(NTSC_VIRTUAL_ROW_BYTES % 4 == 0, "Virtual framebuffer rows must be a whole number of words");
+
+// Viewport scrolling
+//  0: The viewport stays at the top left corner of the framebuffer
+//  1: ntsc_scroll moves the viewport for the whole frame
+//  2: ntsc_line_scroll[] moves it per viewport row, e.g. for a fixed
+//     status bar under a scrolling playfield
+// Scroll positions are latched at vertical blanking and wrap around the
+// edges of the virtual framebuffer. Packed pixel formats scroll
+// horizontally in whole bytes, 8 / NTSC_PIXEL_BITS pixels at a time
+#ifndef NTSC_SCROLL
+#define NTSC_SCROLL 0
+#endif
+
+#if NTSC_SCROLL && !NTSC_HAS_FRAMEBUFFER
+#error "NTSC_SCROLL needs a framebuffer, it can't be used with NTSC_TILE_MODE, NTSC_LINE_CALLBACK or NTSC_STREAM_INPUT"
+#endif
+
+// Double-buffered framebuffer
+//  0: Single page, the application draws into the page being displayed
+//  1: Two pages, the application draws into a back page and flips it in with
+//     ntsc_swap_buffers(), the flip is applied during vertical blanking
+#ifndef NTSC_DOUBLE_BUFFER
+#define NTSC_DOUBLE_BUFFER 0
+#endif
+
+#if NTSC_TILE_MODE
+// Tile geometry, the map covers the whole frame
+#define NTSC_TILE_SIZE     8
+#define NTSC_TILE_COLUMNS  (NTSC_FRAME_WIDTH / NTSC_TILE_SIZE)
+#define NTSC_TILE_ROWS     ((NTSC_FRAME_HEIGHT + NTSC_TILE_SIZE - 1) / NTSC_TILE_SIZE)
+
+// Tiles in the pattern table, the map stores 8-bit tile indices
+#ifndef NTSC_TILE_COUNT
+#define NTSC_TILE_COUNT    128
+#endif
+
+_Static_assert(NTSC_FRAME_WIDTH % NTSC_TILE_SIZE == 0, "NTSC_FRAME_WIDTH must be a multiple of the tile size");
+_Static_assert(NTSC_TILE_COUNT >= 1 && NTSC_TILE_COUNT <= 256, "NTSC_TILE_COUNT must fit 8-bit tile indices");
+#if NTSC_DOUBLE_BUFFER
+#error "NTSC_DOUBLE_BUFFER needs a framebuffer, it can't be used with NTSC_TILE_MODE"
+#endif
+
+// Tile map, one tile index per cell, row by row
+static uint8_t ntsc_tile_map[NTSC_TILE_ROWS * NTSC_TILE_COLUMNS];
+
+// Tile pattern table - 8x8 pixels of 8-bit color per tile, row by row
+// Aligned to the 4-byte boundary for the word-at-a-time line expansion
+static uint8_t ntsc_tile_patterns[NTSC_TILE_COUNT][NTSC_TILE_SIZE * NTSC_TILE_SIZE] __attribute__ ((aligned (4)));
+
+// Pixel row expanded from the tile map for the active line kernel
+static uint8_t ntsc_tile_line[NTSC_FRAME_WIDTH] __attribute__ ((aligned (4)));
+#elif NTSC_LINE_CALLBACK
+#if NTSC_DOUBLE_BUFFER
+#error "NTSC_DOUBLE_BUFFER needs a framebuffer, it can't be used with NTSC_LINE_CALLBACK"
+#endif
+
+// Fills framebuffer row `row` (0 to NTSC_FRAME_HEIGHT - 1) into `pixels`,
+// NTSC_FRAME_ROW_BYTES bytes in the NTSC_PIXEL_BITS format
+// Called from the DMA interrupt on the video core, a few scanlines before
+// the row goes on air, so it must live in RAM and return within the
+// latency budget along with the encoder
+typedef void (*ntsc_line_callback_t)(uint row, uint8_t *pixels);
+
+// Line callback, NULL leaves the line buffer unchanged
+static volatile ntsc_line_callback_t ntsc_line_callback;
+
+// Row filled by the line callback for the active line kernel
+static uint8_t ntsc_callback_line[NTSC_FRAME_ROW_BYTES] __attribute__ ((aligned (4)));
+#elif NTSC_STREAM_INPUT
+#if NTSC_DOUBLE_BUFFER
+#error "NTSC_DOUBLE_BUFFER needs a framebuffer, it can't be used with NTSC_STREAM_INPUT"
+#endif
+_Static_assert(NTSC_STREAM_LINES >= 2 && (NTSC_STREAM_LINES & (NTSC_STREAM_LINES - 1)) == 0,
+               "NTSC_STREAM_LINES must be a power of two, at least 2");
+
+// One streamed row, also its wire format: a 4-byte little-endian header
+// and the row's NTSC_FRAME_ROW_BYTES pixel bytes in the NTSC_PIXEL_BITS
+// format, so at 4bpp a 320 pixel row is 164 bytes on the wire
+typedef struct {
+    uint16_t row;                           // Framebuffer row, 0 to NTSC_FRAME_HEIGHT - 1
+    uint16_t reserved;                      // Zero, keeps the pixels word aligned
+    uint8_t pixels[NTSC_FRAME_ROW_BYTES];
+} ntsc_stream_line_t;
+
+// Line ring, aligned to the 4-byte boundary for the active line kernel
+static ntsc_stream_line_t ntsc_stream_lines[NTSC_STREAM_LINES] __attribute__ ((aligned (4)));
+
+// Lines committed by the producer and lines taken off the ring by the
+// video core, free running. Line ntsc_stream_read - 1 is the last one
+// taken and holds the pixels last shown, repeated while no line for the
+// current row has arrived
+static volatile uint32_t ntsc_stream_write;
+static volatile uint32_t ntsc_stream_read;
+
+// Rows shown without a line of their own, and lines that arrived after
+// their row had gone on air and were skipped
+static volatile uint32_t ntsc_stream_underruns;
+static volatile uint32_t ntsc_stream_dropped;
+#elif NTSC_DOUBLE_BUFFER
+// Framebuffer pages - one is scanned out while the other one is drawn
+// Aligned to the 4-byte boundary for efficient DMA transfers
+static uint8_t ntsc_framebuffer_pages[2][NTSC_VIRTUAL_ROW_BYTES * NTSC_VIRTUAL_HEIGHT] __attribute__ ((aligned (4)));
+
+// Back page the application draws into, swapped at vertical blanking
+static uint8_t *volatile ntsc_framebuffer = ntsc_framebuffer_pages[1];
+
+// Front page currently scanned out
+static const uint8_t *volatile ntsc_display_buffer = ntsc_framebuffer_pages[0];
+
+// Set by ntsc_swap_buffers(), cleared once the flip has been applied
+static volatile bool ntsc_swap_pending = false;
+#else
+// Graphics framebuffer - stores raw pixel data for the display
+// Aligned to the 4-byte boundary for efficient DMA transfers
+static uint8_t ntsc_framebuffer[NTSC_VIRTUAL_ROW_BYTES * NTSC_VIRTUAL_HEIGHT] __attribute__ ((aligned (4)));
+
+// Page scanned out - always the framebuffer itself
+static const uint8_t *const ntsc_display_buffer = ntsc_framebuffer;
+#endif
+
+#if NTSC_SCROLL
+// Top left framebuffer pixel of the viewport
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+} ntsc_scroll_t;
+
+#if NTSC_SCROLL == 2
+// Viewport position per frame row: row y shows framebuffer row
+// (y + scroll.y) % NTSC_VIRTUAL_HEIGHT from column scroll.x on
+static ntsc_scroll_t ntsc_line_scroll[NTSC_FRAME_HEIGHT];
+
+// Positions shown this frame, copied from ntsc_line_scroll at vertical blanking
+static ntsc_scroll_t ntsc_line_scroll_shown[NTSC_FRAME_HEIGHT];
+#else
+// Viewport position, set by the application
+static ntsc_scroll_t ntsc_scroll;
+
+// Position shown this frame, copied from ntsc_scroll at vertical blanking
+static ntsc_scroll_t ntsc_scroll_shown;
+#endif
+
+// Viewport row gathered from a wrapping or unaligned framebuffer row
+static uint8_t ntsc_scroll_line[NTSC_FRAME_ROW_BYTES] __attribute__ ((aligned (4)));
+#endif
+
+// Flag indicating active video region processing
+//  1: Currently generating visible scanlines
+//  0: In a vertical blanking interval
+static volatile uint8_t ntsc_is_rendering_active;
+
+// Frame counter - increments after each complete frame, after each field
+// with NTSC_INTERLACE (the end-of-frame work like page flips runs per field)
+// Monotonic for 2^32 frames, over two years at 60 Hz
+static volatile uint32_t ntsc_frame_counter = 0;
+
+// Called with the new frame counter at the start of vertical blanking,
+// after the page flip, palette commit and scroll and sprite latching
+// Called from the DMA interrupt on the video core, so it must live in RAM
+// and return within the latency budget along with the end-of-frame work
+typedef void (*ntsc_vblank_callback_t)(uint32_t frame);
+
+// Vertical blanking callback, NULL for none
+static volatile ntsc_vblank_callback_t ntsc_vblank_callback;
+
+/* ===========================================================================
+ * Statistics
+ * =========================================================================== */
+
+// Interrupt handler timing and late line counters, usable in release builds
+//  0: Not compiled in
+//  1: Every DMA interrupt is timed with the video core's SysTick
+#ifndef NTSC_STATS
+#define NTSC_STATS 0
+#endif
+
+#if NTSC_STATS
+#include <hardware/structs/systick.h>
+
+// Handler cycles for one line type, from handler entry to exit
+// Exception entry and exit (about 24 cycles) are not included
+typedef struct {
+    uint32_t count;                 // Interrupts timed
+    uint32_t min_cycles;            // Fastest interrupt, UINT32_MAX until the first one
+    uint32_t max_cycles;            // Slowest interrupt
+    uint64_t total_cycles;          // Sum over all timed interrupts, see ntsc_stats_average()
+} ntsc_isr_timing_t;
+
+typedef struct {
+    ntsc_isr_timing_t sync;         // Vertical sync lines queued
+    ntsc_isr_timing_t active;       // Active lines encoded
+    ntsc_isr_timing_t blank;        // Blanking lines queued, including the end of frame work
+    uint32_t late_lines;            // Lines sent before the handler had refilled them
+} ntsc_stats_t;
+
+// Updated by the DMA interrupt handler only, fields are updated independently
+// so a reader may see one interrupt counted in some fields and not in others
+// The control list engine wakes up per batch of active lines and once per
+// frame: batches are timed as active, the frame wake-up as blank, and sync
+// stays empty
+static volatile ntsc_stats_t ntsc_stats;
+
+// Set by ntsc_stats_reset(), applied by the handler at the end of the frame
+// Pending from the start, so the partial first frame is never counted
+static volatile bool ntsc_stats_reset_pending = true;
+
+/* ===========================================================================
+ * Function: ntsc_stats_reset
+ * Purpose: Restart statistics from the next frame
+ * =========================================================================== */
+static inline void ntsc_stats_reset() {
+    ntsc_stats_reset_pending = true;
+}
+
+/* ===========================================================================
+ * Function: ntsc_stats_average
+ * Purpose: Average handler cycles for one line type, 0 if none was timed
+ * =========================================================================== */
+static inline uint32_t ntsc_stats_average(const volatile ntsc_isr_timing_t *timing) {
+    const uint32_t count = timing->count;
+    return count ? (uint32_t) (timing->total_cycles / count) : 0;
+}
+
+/* ===========================================================================
+ * Function: ntsc_stats_start
+ * Purpose: Start the SysTick of the calling (video) core as a free running
+ * 24-bit down counter at the processor clock
+ * =========================================================================== */
+static inline void ntsc_stats_start() {
+    systick_hw->csr = 0;
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // ENABLE | CLKSOURCE processor clock, no interrupt
+}
+
+/* ===========================================================================
+ * Function: ntsc_stats_record
+ * Purpose: Account one handler run that started at SysTick value start
+ * =========================================================================== */
+static inline void ntsc_stats_record(volatile ntsc_isr_timing_t *timing, const uint32_t start) {
+    const uint32_t cycles = (start - systick_hw->cvr) & 0x00FFFFFF;
+    timing->count++;
+    timing->total_cycles += cycles;
+    if (cycles < timing->min_cycles)
+        timing->min_cycles = cycles;
+    if (cycles > timing->max_cycles)
+        timing->max_cycles = cycles;
+}
+
+/* ===========================================================================
+ * Function: ntsc_stats_end_of_frame
+ * Purpose: Apply a pending reset, called at vertical blanking
+ * =========================================================================== */
+static inline void ntsc_stats_end_of_frame() {
+    if (!ntsc_stats_reset_pending)
+        return;
+    volatile ntsc_isr_timing_t *const timings[] = { &ntsc_stats.sync, &ntsc_stats.active, &ntsc_stats.blank };
+    for (uint i = 0; i < count_of(timings); i++) {
+        timings[i]->count = 0;
+        timings[i]->min_cycles = UINT32_MAX;
+        timings[i]->max_cycles = 0;
+        timings[i]->total_cycles = 0;
+    }
+    ntsc_stats.late_lines = 0;
+    ntsc_stats_reset_pending = false;
+}
+#endif
+
+/* ===========================================================================
+ * DMA Engine Configuration
+ * =========================================================================== */
+
+// DMA engine feeding the PWM
+//  NTSC_DMA_PINGPONG:     two channels chained back to back, the IRQ queues
+//                         every scanline as the other channel transmits
+//  NTSC_DMA_CONTROL_LIST: a control channel walks a per-frame table of control
+//                         blocks and reprograms the data channel by itself, the
+//                         IRQ only fires every NTSC_LINES_PER_IRQ active lines
+//                         and once per frame
+#define NTSC_DMA_PINGPONG      0
+#define NTSC_DMA_CONTROL_LIST  1
+
+#ifndef NTSC_DMA_ENGINE
+#define NTSC_DMA_ENGINE        NTSC_DMA_PINGPONG
+#endif
+
+// Active lines encoded per IRQ by the control list engine
+// The line ring holds twice as many lines: one half is transmitted while the
+// other half is refilled
+#ifndef NTSC_LINES_PER_IRQ
+#define NTSC_LINES_PER_IRQ     4
+#endif
+#define NTSC_LINE_RING_SIZE    (2 * NTSC_LINES_PER_IRQ)
+
+// Encoded line cache (control list engine with 8-bit samples only)
+//  0: Active lines are encoded into the line ring as they are sent
+//  1: Every row keeps its encoded samples in ntsc_line_cache and the control
+//     list sends them straight from there, only rows marked dirty with
+//     ntsc_mark_dirty() (or drawn with ntsc_put_pixel()) are encoded again,
+//     during vertical blanking and at most NTSC_CACHE_ROWS_PER_FRAME per frame
+#ifndef NTSC_LINE_CACHE
+#define NTSC_LINE_CACHE        0
+#endif
+#ifndef NTSC_CACHE_ROWS_PER_FRAME
+#define NTSC_CACHE_ROWS_PER_FRAME 64
+#endif
+// SRAM the framebuffer and the line cache must leave free of the RP2040's
+// 264 KB, for the stacks, scanline templates, core 1 and the application.
+// 320x240 at 8bpp takes 76.8 KB of framebuffer and 153.6 KB of cache
+// (230.4 KB), which leaves about 34 KB
+#ifndef NTSC_SRAM_RESERVE
+#define NTSC_SRAM_RESERVE      (32 * 1024)
+#endif
+
+#if NTSC_LINE_CACHE
+#if NTSC_DMA_ENGINE != NTSC_DMA_CONTROL_LIST || NTSC_SAMPLE_BITS != 8
+#error "NTSC_LINE_CACHE needs NTSC_DMA_ENGINE=NTSC_DMA_CONTROL_LIST and NTSC_SAMPLE_BITS=8"
+#endif
+#if NTSC_DOUBLE_BUFFER
+#error "NTSC_LINE_CACHE can't be used with NTSC_DOUBLE_BUFFER, a page flip would dirty every row"
+#endif
+#if NTSC_LINE_CALLBACK || NTSC_STREAM_INPUT
+#error "NTSC_LINE_CACHE can't be used with NTSC_LINE_CALLBACK or NTSC_STREAM_INPUT, rows are generated as they are sent"
+#endif
+#if NTSC_SCROLL
+#error "NTSC_LINE_CACHE can't be used with NTSC_SCROLL, scrolling would dirty every row"
+#endif
+// Active lines are sent as three blocks: sync and burst prefix and blanking
+// tail from the line's blank template, active samples from the row's cache entry
+#define NTSC_BLOCKS_PER_ACTIVE_LINE 3
+#else
+#define NTSC_BLOCKS_PER_ACTIVE_LINE 1
+#endif
+
+// DMA interrupt line serviced by the video core, 0 for DMA_IRQ_0 or 1 for
+// DMA_IRQ_1, the handler is exclusive so pick the one the application leaves free
+#ifndef NTSC_DMA_IRQ_INDEX
+#define NTSC_DMA_IRQ_INDEX     0
+#endif
+#define NTSC_DMA_IRQ           (DMA_IRQ_0 + NTSC_DMA_IRQ_INDEX)
+
+#if NTSC_DMA_IRQ_INDEX == 0
+#define NTSC_DMA_INTS          (dma_hw->ints0)
+#elif NTSC_DMA_IRQ_INDEX == 1
+#define NTSC_DMA_INTS          (dma_hw->ints1)
+#else
+#error "NTSC_DMA_IRQ_INDEX must be 0 or 1"
+#endif
+
+#if NTSC_STREAM_INPUT
+// The stream DMA channel interrupts on the other DMA interrupt line,
+// through a shared handler
+#define NTSC_STREAM_DMA_IRQ    (DMA_IRQ_0 + 1 - NTSC_DMA_IRQ_INDEX)
+#if NTSC_DMA_IRQ_INDEX == 0
+#define NTSC_STREAM_DMA_INTS   (dma_hw->ints1)
+#else
+#define NTSC_STREAM_DMA_INTS   (dma_hw->ints0)
+#endif
+#endif
+
+// Scanline buffer size, aligned to the 4-byte boundary for DMA efficiency
+#define NTSC_LINE_BUFFER_SIZE  ((NTSC_SAMPLES_PER_LINE + 3) & ~3u)
+
+// DMA transfers per scanline
+#define NTSC_TRANSFERS_PER_LINE (NTSC_SAMPLES_PER_LINE / NTSC_SAMPLES_PER_TRANSFER)
+
+// Packed 8-bit samples and 32-bit stores in the encoder need 4-sample alignment
+_Static_assert(NTSC_SAMPLES_PER_LINE % 4 == 0 && NTSC_ACTIVE_START % 4 == 0, "Scanline layout not 4-sample aligned");
+
+#if NTSC_DMA_ENGINE == NTSC_DMA_CONTROL_LIST
+// Control block as loaded into the data channel's alias 3 registers
+// (CTRL, WRITE_ADDR, TRANS_COUNT, READ_ADDR_TRIG), one block per scanline,
+// or NTSC_BLOCKS_PER_ACTIVE_LINE blocks per active line
+typedef struct {
+    uint32_t ctrl;                  // Data channel CTRL, IRQ_QUIET cleared on wake-up blocks
+    volatile void *write_addr;      // PWM compare register
+    uint32_t transfer_count;        // DMA transfers in this block
+    const void *read_addr;          // Samples to transmit, writing it starts the data channel
+} ntsc_dma_block_t;
+
+// Per-frame control block table, followed by a NULL terminator that stops
+// the chain (and raises the IRQ) if the once-per-frame rewind is missed
+#define NTSC_DMA_BLOCK_COUNT (NTSC_TOTAL_LINES + (NTSC_BLOCKS_PER_ACTIVE_LINE - 1) * NTSC_ACTIVE_LINES * NTSC_FIELDS)
+static ntsc_dma_block_t ntsc_dma_blocks[NTSC_DMA_BLOCK_COUNT + 1] __attribute__ ((aligned (16)));
+
+#if NTSC_LINE_CACHE
+// Encoded active samples of every row, 640 bytes per row at 320 pixels
+static ntsc_sample_t ntsc_line_cache[NTSC_FRAME_HEIGHT][NTSC_ACTIVE_SAMPLES] __attribute__ ((aligned (4)));
+_Static_assert(NTSC_HAS_FRAMEBUFFER * NTSC_VIRTUAL_ROW_BYTES * NTSC_VIRTUAL_HEIGHT + sizeof(ntsc_line_cache) <=
+               264 * 1024 - NTSC_SRAM_RESERVE, "Framebuffer and line cache leave less than NTSC_SRAM_RESERVE bytes of SRAM");
+
+// Rows to encode again, set by the application and cleared by the video
+// core before it encodes the row, so a row drawn meanwhile stays dirty
+static volatile uint8_t ntsc_dirty_rows[NTSC_FRAME_HEIGHT];
+
+// Row the next cache refresh starts looking for dirty rows
+static uint ntsc_cache_scan_row;
+#else
+// Ring of encoded active lines, active row y is transmitted from slot y % NTSC_LINE_RING_SIZE
+// The sync and burst prefix and the blanking tail are copied from the blank
+// template of the slot's lines once at init (slots keep their line parity)
+static ntsc_sample_t ntsc_line_ring[NTSC_LINE_RING_SIZE][NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+#endif
+
+// DMA channels: data channel feeding the PWM and control channel reprogramming it
+static uint ntsc_dma_chan_primary, ntsc_dma_chan_control;
+#else
+// Ping-pong buffers for DMA double-buffering
+// While one buffer is being transmitted, the other is prepared
+// Only the active video window is rewritten, the sync and burst prefix and the
+// blanking tail are copied from ntsc_line_blank once at init (with PAL buffer
+// i carries the lines of parity i and their blank template)
+static ntsc_sample_t ntsc_scanline_buffers[2][NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+
+// DMA channel handles for ping-pong operation
+static uint ntsc_dma_chan_primary, ntsc_dma_chan_secondary;
+#endif
+
+// Precomputed sync and blanking lines, built once by ntsc_init()
+// They are identical in every frame, so non-active scanlines are streamed by
+// DMA straight from these templates without any sample generation
+static ntsc_sample_t ntsc_line_vsync[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+static ntsc_sample_t ntsc_line_blank[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+
+#if NTSC_PAL
+// PAL blanking line of odd scanlines, burst at 225° instead of 135°
+static ntsc_sample_t ntsc_line_blank_alternate[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_blank_template
+ * Purpose: Blanking template of frame scanline `line`, also the sync and
+ * burst prefix and the blanking tail of an active line
+ * =========================================================================== */
+static inline const ntsc_sample_t *ntsc_blank_template(const uint line) {
+#if NTSC_PAL
+    return line & 1 ? ntsc_line_blank_alternate : ntsc_line_blank;
+#else
+    (void) line;
+    return ntsc_line_blank;
+#endif
+}
+
+#if NTSC_INTERLACE
+// Interlaced vertical sync works in half lines: 6 equalizing pulses, 6
+// serrated vsync pulses and 6 equalizing pulses again, the second field's
+// sequence starts half a line later. Every scanline stays a whole line, so
+// the lines around it are built from two half-line pulses each, and
+// ntsc_line_vsync holds two serrated vsync pulses
+static ntsc_sample_t ntsc_line_equalizing[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+static ntsc_sample_t ntsc_line_equalizing_vsync[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+static ntsc_sample_t ntsc_line_vsync_equalizing[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+static ntsc_sample_t ntsc_line_blank_equalizing[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+static ntsc_sample_t ntsc_line_equalizing_blank[NTSC_LINE_BUFFER_SIZE] __attribute__ ((aligned (4)));
+
+// Vertical sync lines of each field, the first field has one line less
+static const ntsc_sample_t *const ntsc_vsync_lines[2][NTSC_VSYNC_LINES + 1] = {
+    {
+        ntsc_line_equalizing, ntsc_line_equalizing, ntsc_line_equalizing,
+        ntsc_line_vsync, ntsc_line_vsync, ntsc_line_vsync,
+        ntsc_line_equalizing, ntsc_line_equalizing, ntsc_line_equalizing,
+    },
+    {
+        ntsc_line_blank_equalizing, ntsc_line_equalizing, ntsc_line_equalizing,
+        ntsc_line_equalizing_vsync, ntsc_line_vsync, ntsc_line_vsync,
+        ntsc_line_vsync_equalizing, ntsc_line_equalizing, ntsc_line_equalizing,
+        ntsc_line_equalizing_blank,
+    },
+};
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_field_of_line
+ * Purpose: Field of frame scanline `line`, 0 without interlace
+ * =========================================================================== */
+static inline uint ntsc_field_of_line(const uint line) {
+    return NTSC_INTERLACE && line >= NTSC_FIELD_LINES;
+}
+
+/* ===========================================================================
+ * Function: ntsc_vsync_template
+ * Purpose: Vertical sync template sent as frame scanline `line`, NULL for
+ * blanking and active lines
+ * =========================================================================== */
+static inline const ntsc_sample_t *ntsc_vsync_template(const uint line) {
+#if NTSC_INTERLACE
+    const uint field = ntsc_field_of_line(line);
+    const uint field_line = line - field * NTSC_FIELD_LINES;
+    return field_line < NTSC_VSYNC_LINES + field ? ntsc_vsync_lines[field][field_line] : NULL;
+#else
+    return line < NTSC_VSYNC_LINES ? ntsc_line_vsync : NULL;
+#endif
+}
+
+// NTSC color palette lookup table
+// Each color has 4 entries for the 4 phases of NTSC color subcarrier (0°, 90°, 180°, 270°)
+// This allows proper color encoding at 3.579545 MHz
+// PAL keeps a second palette right after the first one for the odd
+// scanlines, where the (R-Y) component is inverted
+#define NTSC_PALETTE_LINES  (NTSC_PAL ? 2 : 1)
+#define NTSC_PALETTE_SIZE   (4 * 256)  // Samples per palette
+
+// Chroma modulation weights of (B-Y) and (R-Y) at the 4 subcarrier phases
+// Original formula: signal = Y + 0.4921*(B-Y)*sin(θ) + 0.8773*(R-Y)*cos(θ)
+// These compensate for phase shifts in the NTSC encoding
+// PAL weights are 1.414 times larger to match the larger PAL burst, the odd
+// line palette swaps the 0° and 180° weights: with its (R-Y) inverted back
+// by the TV, it decodes to the same hue as the even line
+// NTSC_CHROMA_WEIGHT() is the weight of (B-Y) (component 0) or (R-Y)
+// (component 1) as a constant expression, for palettes built by the compiler
+#define NTSC_CHROMA_WEIGHT_0(component)  (NTSC_PAL ? ((component) ? 1925 : 624) : ((component) ? 1361 : 441))
+#define NTSC_CHROMA_WEIGHT_90(component) (NTSC_PAL ? ((component) ? -1112 : 1080) : ((component) ? -786 : 764))
+#define NTSC_CHROMA_WEIGHT(line, phase, component) \
+    (((phase) & 1 ? NTSC_CHROMA_WEIGHT_90(component) : NTSC_CHROMA_WEIGHT_0(component)) * \
+     ((phase) & 2 ? -1 : 1) * ((line) && !((phase) & 1) ? -1 : 1))
+
+static const int32_t ntsc_chroma_weights[NTSC_PALETTE_LINES][4][2] = {
+    {
+        { NTSC_CHROMA_WEIGHT(0, 0, 0), NTSC_CHROMA_WEIGHT(0, 0, 1) }, // Phase 0°: Y + chroma
+        { NTSC_CHROMA_WEIGHT(0, 1, 0), NTSC_CHROMA_WEIGHT(0, 1, 1) }, // Phase 90°: Y + chroma(90°)
+        { NTSC_CHROMA_WEIGHT(0, 2, 0), NTSC_CHROMA_WEIGHT(0, 2, 1) }, // Phase 180°: Y - chroma
+        { NTSC_CHROMA_WEIGHT(0, 3, 0), NTSC_CHROMA_WEIGHT(0, 3, 1) }, // Phase 270°: Y - chroma(90°)
+    },
+#if NTSC_PAL
+    {
+        { NTSC_CHROMA_WEIGHT(1, 0, 0), NTSC_CHROMA_WEIGHT(1, 0, 1) }, // Phase 0°: Y - chroma
+        { NTSC_CHROMA_WEIGHT(1, 1, 0), NTSC_CHROMA_WEIGHT(1, 1, 1) }, // Phase 90°: Y + chroma(90°)
+        { NTSC_CHROMA_WEIGHT(1, 2, 0), NTSC_CHROMA_WEIGHT(1, 2, 1) }, // Phase 180°: Y + chroma
+        { NTSC_CHROMA_WEIGHT(1, 3, 0), NTSC_CHROMA_WEIGHT(1, 3, 1) }, // Phase 270°: Y - chroma(90°)
+    },
+#endif
+};
+
+// Luminance of 8-bit color components with the standard weights
+// Y = 0.587*G + 0.114*B + 0.299*R
+// Using integer math: (150*G + 29*B + 77*R) / 256
+#define NTSC_LUMINANCE(blue, red, green) ((150 * (green) + 29 * (blue) + 77 * (red) + 128) / 256)
+
+// Composite signal of a color at one phase, in 1/65536 output levels:
+// luminance, (B-Y) * 0.4921 and (R-Y) * 0.8773 through the phase's chroma
+// weights, on top of the blanking level
+#define NTSC_COMPOSITE_SIGNAL(luminance, blue, red, blue_weight, red_weight) \
+    NTSC_LEVEL((luminance) * 1792 + ((blue) - (luminance)) * (blue_weight) + ((red) - (luminance)) * (red_weight) + 2 * 65536)
+
+// Sample of a composite signal rounded to the nearest output level
+#define NTSC_SIGNAL_SAMPLE(signal) NTSC_SAMPLE(MIN(MAX(((signal) + 32768) / 65536, 0), NTSC_LEVEL_MAX))
+
+// Sample of a 0xRRGGBB color at one phase of palette line `line`, the
+// ntsc_set_color() value as a constant expression
+#define NTSC_RGB_SAMPLE(rgb, line, phase) \
+    NTSC_SIGNAL_SAMPLE(NTSC_COMPOSITE_SIGNAL(NTSC_LUMINANCE((rgb) & 0xFF, (rgb) >> 16 & 0xFF, (rgb) >> 8 & 0xFF), \
+                                             (rgb) & 0xFF, (rgb) >> 16 & 0xFF, \
+                                             NTSC_CHROMA_WEIGHT(line, phase, 0), NTSC_CHROMA_WEIGHT(line, phase, 1)))
+
+// Palette color fitting
+//  0: ntsc_set_color() rounds each phase sample to the nearest output level
+//     on its own and clips samples outside the output levels
+//  1: the 4 phase samples of a color are fitted together: a color whose
+//     chroma swings past the output levels keeps its luma and hue and loses
+//     only saturation, and each sample is rounded up or down so the color's
+//     luma and chroma come closest, the rounding error left in the 2x
+//     subcarrier pattern the TV filters out. Half levels of luma, e.g. the
+//     grays between the output levels, are sent as alternating samples
+// Only ntsc_set_color() changes, the scanline encoders do not. The fit
+// runs there, once per color, and is the only way fitted samples are made:
+// there is no offline table generator. RGB565 pixels, which have no
+// palette, keep plain rounding
+#ifndef NTSC_PHASE_DITHER
+#define NTSC_PHASE_DITHER 0
+#endif
+
+// Palette at boot
+// NTSC_PALETTE_COLORS, if defined before this file is included, lists the
+// palette as an X-macro of up to 256 0xRRGGBB colors, entry 0 first:
+//   #define NTSC_PALETTE_COLORS(COLOR) COLOR(0x000000) COLOR(0x0000AA) ...
+// The compiler computes their samples in the configured sample format and
+// ntsc_palette starts out as initialized data, copied from flash by the C
+// runtime before main(): no ntsc_set_color() calls at boot, and the
+// palette stays in RAM for the encoders and ntsc_set_color(). The values
+// are those ntsc_set_color() gives; NTSC_PHASE_DITHER fits are not
+// constant expressions, with it the colors are kept in flash and set by
+// ntsc_init() instead. Without NTSC_PALETTE_COLORS the palette starts
+// out zeroed until the application sets its colors
+#if defined(NTSC_PALETTE_COLORS) && !NTSC_PHASE_DITHER
+#define NTSC_PALETTE_SAMPLES_0(rgb) \
+    NTSC_RGB_SAMPLE(rgb, 0, 0), NTSC_RGB_SAMPLE(rgb, 0, 1), NTSC_RGB_SAMPLE(rgb, 0, 2), NTSC_RGB_SAMPLE(rgb, 0, 3),
+#define NTSC_PALETTE_SAMPLES_1(rgb) \
+    NTSC_RGB_SAMPLE(rgb, 1, 0), NTSC_RGB_SAMPLE(rgb, 1, 1), NTSC_RGB_SAMPLE(rgb, 1, 2), NTSC_RGB_SAMPLE(rgb, 1, 3),
+#if NTSC_PAL
+#define NTSC_PALETTE_INIT { NTSC_PALETTE_COLORS(NTSC_PALETTE_SAMPLES_0) \
+                            [NTSC_PALETTE_SIZE] = NTSC_PALETTE_COLORS(NTSC_PALETTE_SAMPLES_1) }
+#else
+#define NTSC_PALETTE_INIT { NTSC_PALETTE_COLORS(NTSC_PALETTE_SAMPLES_0) }
+#endif
+#else
+#define NTSC_PALETTE_INIT { 0 }
+#endif
+
+#ifdef NTSC_PALETTE_COLORS
+#define NTSC_PALETTE_RGB(rgb) rgb,
+_Static_assert(sizeof((const uint32_t[]) { NTSC_PALETTE_COLORS(NTSC_PALETTE_RGB) }) <= 256 * sizeof(uint32_t),
+               "NTSC_PALETTE_COLORS lists more than 256 colors");
+#endif
+
+static ntsc_sample_t ntsc_palette[NTSC_PALETTE_LINES * NTSC_PALETTE_SIZE] __attribute__ ((aligned (4))) = NTSC_PALETTE_INIT;
+
+/* ===========================================================================
+ * Function: ntsc_palette_line
+ * Purpose: Palette (0, or 1 on PAL odd scanlines) of framebuffer row `row`
+ * =========================================================================== */
+static inline uint ntsc_palette_line(const uint row) {
+#if NTSC_PAL
+    // Row / NTSC_FIELDS is the row's line in its field, fields start on even lines
+    return (NTSC_ACTIVE_FIRST_LINE + row / NTSC_FIELDS) & 1;
+#else
+    (void) row;
+    return 0;
+#endif
+}
+
+// One color's samples at the 4 subcarrier phases, moved as a unit by
+// ntsc_rotate_palette()
+typedef struct {
+    ntsc_sample_t phase[4];
+} ntsc_palette_entry_t;
+
+// Double-buffered palette
+//  0: ntsc_set_color() writes the palette being displayed
+//  1: ntsc_set_color() and ntsc_rotate_palette() write a back palette that
+//     ntsc_commit_palette() copies into ntsc_palette at vertical blanking
+#ifndef NTSC_DOUBLE_PALETTE
+#define NTSC_DOUBLE_PALETTE 0
+#endif
+
+#if NTSC_DOUBLE_PALETTE
+// Back palette, kept after a commit as the base for further changes
+static ntsc_sample_t ntsc_back_palette[NTSC_PALETTE_LINES * NTSC_PALETTE_SIZE] __attribute__ ((aligned (4))) = NTSC_PALETTE_INIT;
+
+// Set by ntsc_commit_palette(), cleared once the palette has been copied
+static volatile bool ntsc_palette_commit_pending = false;
+
+// Palette written by the application helpers
+static ntsc_sample_t *const ntsc_edit_palette = ntsc_back_palette;
+#else
+static ntsc_sample_t *const ntsc_edit_palette = ntsc_palette;
+#endif
+
+#if NTSC_PIXEL_BITS < 8
+// Packed pixels are expanded a group at a time, a byte for 4bpp and 2bpp
+// and a nibble for 1bpp, through a table of the samples of every possible
+// group: each pixel's 0°/90° or 180°/270° pair from ntsc_palette, so the
+// encoder copies whole words and never looks at a single pixel
+#define NTSC_GROUP_PIXELS    (NTSC_PIXEL_BITS == 1 ? 4 : 8 / NTSC_PIXEL_BITS)
+#define NTSC_GROUP_BITS      (NTSC_PIXEL_BITS * NTSC_GROUP_PIXELS)
+#define NTSC_GROUP_SAMPLES   (NTSC_GROUP_PIXELS * NTSC_SAMPLES_PER_PIXEL)
+#define NTSC_GROUP_BYTES     (NTSC_GROUP_SAMPLES * NTSC_SAMPLE_BITS / 8)
+
+// Groups of 2 samples (4bpp at 1 sample per pixel) alternate between the
+// 0°/90° and the 180°/270° phases, the table then holds both
+#define NTSC_GROUP_PHASES    (NTSC_GROUP_SAMPLES % 4 ? 2 : 1)
+
+// Groups are copied in words, or half words when smaller than a word
+#if NTSC_GROUP_BYTES % 4
+typedef uint16_t ntsc_group_unit_t;
+#else
+typedef uint32_t ntsc_group_unit_t;
+#endif
+#define NTSC_GROUP_UNITS     (NTSC_GROUP_BYTES / sizeof(ntsc_group_unit_t))
+
+// One table per palette
+typedef ntsc_group_unit_t ntsc_group_table_t[NTSC_GROUP_PHASES][1 << NTSC_GROUP_BITS][NTSC_GROUP_UNITS];
+static ntsc_group_table_t ntsc_group_palette[NTSC_PALETTE_LINES] __attribute__ ((aligned (4)));
+#endif
+
+#if NTSC_PIXEL_BITS == 16
+// RGB565 pixels are encoded without a palette: the composite signal is
+// linear in the color components, so a sample is the sum of a high byte
+// (red, upper green bits) and a low byte (lower green bits, blue) part,
+// in 1/2^NTSC_RGB565_SHIFT levels, from per-phase tables
+#define NTSC_RGB565_SHIFT 24
+
+// Levels added to the low byte table so the sum is never negative
+#define NTSC_RGB565_BIAS  4
+
+// One pair of tables per palette line (see ntsc_palette_line())
+static int32_t ntsc_rgb565_high[NTSC_PALETTE_LINES][4][256];
+static int32_t ntsc_rgb565_low[NTSC_PALETTE_LINES][4][256];
+
+// Samples of the biased signal levels, clamped to the output levels 0..NTSC_LEVEL_MAX
+static ntsc_sample_t ntsc_rgb565_samples[NTSC_LEVEL(NTSC_RGB565_BIAS + 16)];
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_build_blank_line
+ * Purpose: Build a blanking scanline, `swing` (-1, 0 or 1) is added to the
+ * 0° and subtracted from the 180° burst samples: 0 for the NTSC burst, 1 and
+ * -1 turn it by -45° and +45° for the PAL burst at 135° and 225°
+ * =========================================================================== */
+static void ntsc_build_blank_line(ntsc_sample_t *line, const int swing) {
+    ntsc_sample_t *buffer_ptr = line;
+
+    // Horizontal sync pulse
+    for (int j = 0; j < NTSC_HSYNC_WIDTH; j++)
+        *buffer_ptr++ = NTSC_SAMPLE(NTSC_LEVEL_SYNC);
+
+    // Back porch before color burst
+    for (int j = NTSC_HSYNC_WIDTH; j < NTSC_BURST_START; j++)
+        *buffer_ptr++ = NTSC_SAMPLE(NTSC_LEVEL_BLANK);
+
+    // Color burst signal - NTSC_BURST_CYCLES cycles of the subcarrier
+    // Alternates between levels to create a reference signal for color decoding
+    for (int j = 0; j < NTSC_BURST_CYCLES; j++) {
+        *buffer_ptr++ = NTSC_SAMPLE(NTSC_LEVEL_BLANK + NTSC_LEVEL(swing)); // Phase 0°
+        *buffer_ptr++ = NTSC_SAMPLE(NTSC_LEVEL_BURST_LOW);                 // Phase 90°
+        *buffer_ptr++ = NTSC_SAMPLE(NTSC_LEVEL_BLANK - NTSC_LEVEL(swing)); // Phase 180°
+        *buffer_ptr++ = NTSC_SAMPLE(NTSC_LEVEL_BURST_HIGH);    // Phase 270°
+    }
+
+    // Fill remainder with blanking level
+    while (buffer_ptr < line + NTSC_SAMPLES_PER_LINE)
+        *buffer_ptr++ = NTSC_SAMPLE(NTSC_LEVEL_BLANK);
+}
+
+/* ===========================================================================
+ * Function: ntsc_build_line_templates
+ * Purpose: Build the constant vertical sync and blanking scanlines
+ * =========================================================================== */
+static void ntsc_build_line_templates() {
+    // Vertical sync line: sync level for most of the line,
+    // back to blanking level for the last horizontal sync width
+    for (int j = 0; j < NTSC_SAMPLES_PER_LINE; j++)
+        ntsc_line_vsync[j] = j < NTSC_SAMPLES_PER_LINE - NTSC_HSYNC_WIDTH ? NTSC_SAMPLE(NTSC_LEVEL_SYNC) : NTSC_SAMPLE(NTSC_LEVEL_BLANK);
+
+#if NTSC_PAL
+    ntsc_build_blank_line(ntsc_line_blank, 1);
+    ntsc_build_blank_line(ntsc_line_blank_alternate, -1);
+#else
+    ntsc_build_blank_line(ntsc_line_blank, 0);
+#endif
+
+#if NTSC_INTERLACE
+    // Half-line pulses: sync level for the pulse width, then blanking
+    const int half = NTSC_SAMPLES_PER_LINE / 2;
+    const int vsync_width = half - NTSC_HSYNC_WIDTH;
+    for (int j = 0; j < half; j++) {
+        const ntsc_sample_t equalizing = j < NTSC_EQUALIZING_WIDTH ? NTSC_SAMPLE(NTSC_LEVEL_SYNC) : NTSC_SAMPLE(NTSC_LEVEL_BLANK);
+        const ntsc_sample_t vsync = j < vsync_width ? NTSC_SAMPLE(NTSC_LEVEL_SYNC) : NTSC_SAMPLE(NTSC_LEVEL_BLANK);
+
+        ntsc_line_equalizing[j] = ntsc_line_equalizing[half + j] = equalizing;
+        ntsc_line_vsync[j] = ntsc_line_vsync[half + j] = vsync;
+        ntsc_line_equalizing_vsync[j] = ntsc_line_vsync_equalizing[half + j] = equalizing;
+        ntsc_line_equalizing_vsync[half + j] = ntsc_line_vsync_equalizing[j] = vsync;
+        // The first field ends with the first half of a regular line, the
+        // second field's sync ends with a half line of plain blanking
+        ntsc_line_blank_equalizing[j] = ntsc_line_blank[j];
+        ntsc_line_blank_equalizing[half + j] = equalizing;
+        ntsc_line_equalizing_blank[j] = equalizing;
+        ntsc_line_equalizing_blank[half + j] = NTSC_SAMPLE(NTSC_LEVEL_BLANK);
+    }
+#endif
+
+    // Active scanlines share the blank line prefix and tail
+#if NTSC_LINE_CACHE
+    // Sent from the template itself
+#elif NTSC_DMA_ENGINE == NTSC_DMA_CONTROL_LIST
+    for (int i = 0; i < NTSC_LINE_RING_SIZE; i++)
+        for (int j = 0; j < NTSC_SAMPLES_PER_LINE; j++)
+            ntsc_line_ring[i][j] = ntsc_blank_template(NTSC_ACTIVE_FIRST_LINE + i)[j];
+#else
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < NTSC_SAMPLES_PER_LINE; j++)
+            ntsc_scanline_buffers[i][j] = ntsc_blank_template(i)[j];
+#endif
+}
+
+// Use the hardware interpolator for palette address generation in the
+// active line kernel
+#ifndef NTSC_USE_INTERP
+#define NTSC_USE_INTERP 0
+#endif
+
+#if NTSC_USE_INTERP
+#include <hardware/interp.h>
+#endif
+
+// log2 of the palette entry size in bytes (4 phases per color)
+#define NTSC_PALETTE_ENTRY_SHIFT (NTSC_SAMPLE_BITS == 8 ? 2 : 3)
+
+#if NTSC_USE_INTERP && NTSC_SAMPLES_PER_PIXEL == 2
+/* ===========================================================================
+ * Function: ntsc_encode_pixels (interpolator variant)
+ * Purpose: Encode a run of 8-bit pixels into NTSC samples (active line kernel)
+ * INTERP0 turns a word of 4 pixels into palette entry addresses: lane 0
+ * yields the even pixel's 0°/90° entry, lane 1 (cross input) the odd
+ * pixel's 180°/270° entry, read back from the lanes' peek registers. The
+ * interpolator state is saved and restored since this runs in IRQ context.
+ * Whether this beats the plain variant has not been measured on target,
+ * compare ntsc-tv-bench-interp with ntsc-tv-bench before relying on it.
+ * Same alignment requirements as the plain variant.
+ * =========================================================================== */
+static void __time_critical_func(ntsc_encode_pixels)(ntsc_sample_t *output, const uint8_t *pixels, const uint pixel_count,
+                                                       const ntsc_sample_t *palette) {
+    const uint32_t *pixel_quads = (const uint32_t *) pixels;
+    uint32_t *output_words = (uint32_t *) output;
+
+    interp_hw_save_t saved_state;
+    interp_save(interp0, &saved_state);
+
+    // Pixels are written pre-scaled by the palette entry size, each lane
+    // masks out one pixel and adds its phase base
+    interp_config even_lane = interp_default_config();
+    interp_config_set_mask(&even_lane, NTSC_PALETTE_ENTRY_SHIFT, NTSC_PALETTE_ENTRY_SHIFT + 7);
+    interp_set_config(interp0, 0, &even_lane);
+
+    interp_config odd_lane = interp_default_config();
+    interp_config_set_cross_input(&odd_lane, true);
+    interp_config_set_shift(&odd_lane, 8);
+    interp_config_set_mask(&odd_lane, NTSC_PALETTE_ENTRY_SHIFT, NTSC_PALETTE_ENTRY_SHIFT + 7);
+    interp_set_config(interp0, 1, &odd_lane);
+
+    interp0->base[0] = (uintptr_t) palette;
+    interp0->base[1] = (uintptr_t) (palette + 2);
+
+    for (uint quads = pixel_count / 4; quads; quads--) {
+        const uint32_t quad = *pixel_quads++;
+#if NTSC_SAMPLE_BITS == 8
+        interp0->accum[0] = quad << NTSC_PALETTE_ENTRY_SHIFT;
+        output_words[0] = *(const uint16_t *) (uintptr_t) interp0->peek[0] |
+                          *(const uint16_t *) (uintptr_t) interp0->peek[1] << 16;
+        interp0->accum[0] = quad >> (16 - NTSC_PALETTE_ENTRY_SHIFT);
+        output_words[1] = *(const uint16_t *) (uintptr_t) interp0->peek[0] |
+                          *(const uint16_t *) (uintptr_t) interp0->peek[1] << 16;
+        output_words += 2;
+#else
+        interp0->accum[0] = quad << NTSC_PALETTE_ENTRY_SHIFT;
+        output_words[0] = *(const uint32_t *) (uintptr_t) interp0->peek[0];
+        output_words[1] = *(const uint32_t *) (uintptr_t) interp0->peek[1];
+        interp0->accum[0] = quad >> (16 - NTSC_PALETTE_ENTRY_SHIFT);
+        output_words[2] = *(const uint32_t *) (uintptr_t) interp0->peek[0];
+        output_words[3] = *(const uint32_t *) (uintptr_t) interp0->peek[1];
+        output_words += 4;
+#endif
+    }
+
+    interp_restore(interp0, &saved_state);
+}
+#else
+/* ===========================================================================
+ * Function: ntsc_encode_pixels
+ * Purpose: Encode a run of 8-bit pixels into NTSC samples (active line kernel)
+ * Loads 4 pixels per 32-bit read and handles the even/odd phase pairs
+ * explicitly, so there is no per-pixel parity test. The palette base (and
+ * the odd phase base) stay in registers across the whole run.
+ * Above 320 pixels each pixel is a single sample at phase x % 4 instead.
+ * pixels must be 4-byte aligned, pixel_count a multiple of 4, and the run
+ * must start on an even pixel so the subcarrier phase matches.
+ * palette is the row's palette inside ntsc_palette (see ntsc_palette_line()).
+ * =========================================================================== */
+static void __time_critical_func(ntsc_encode_pixels)(ntsc_sample_t *output, const uint8_t *pixels, const uint pixel_count,
+                                                       const ntsc_sample_t *palette) {
+    const uint32_t *pixel_quads = (const uint32_t *) pixels;
+    uint32_t *output_words = (uint32_t *) output;
+
+#if NTSC_SAMPLES_PER_PIXEL == 1
+    // One sample per pixel, the 4 pixels of a quad take the 4 phases in turn
+    for (uint quads = pixel_count / 4; quads; quads--) {
+        const uint32_t quad = *pixel_quads++;
+#if NTSC_SAMPLE_BITS == 8
+        output_words[0] = (uint32_t) palette[(quad & 0xFF) * 4] |
+                          (uint32_t) palette[(quad >> 8 & 0xFF) * 4 + 1] << 8 |
+                          (uint32_t) palette[(quad >> 16 & 0xFF) * 4 + 2] << 16 |
+                          (uint32_t) palette[(quad >> 24) * 4 + 3] << 24;
+        output_words += 1;
+#else
+        output_words[0] = (uint32_t) palette[(quad & 0xFF) * 4] | (uint32_t) palette[(quad >> 8 & 0xFF) * 4 + 1] << 16;
+        output_words[1] = (uint32_t) palette[(quad >> 16 & 0xFF) * 4 + 2] | (uint32_t) palette[(quad >> 24) * 4 + 3] << 16;
+        output_words += 2;
+#endif
+    }
+#elif NTSC_SAMPLE_BITS == 8
+    // One word per color: phases 0° and 90° in the low half (even pixels),
+    // 180° and 270° in the high half (odd pixels)
+    const uint32_t *palette_words = (const uint32_t *) palette;
+
+    for (uint quads = pixel_count / 4; quads; quads--) {
+        const uint32_t quad = *pixel_quads++;
+        output_words[0] = (palette_words[quad & 0xFF] & 0x0000FFFF) | (palette_words[quad >> 8 & 0xFF] & 0xFFFF0000);
+        output_words[1] = (palette_words[quad >> 16 & 0xFF] & 0x0000FFFF) | (palette_words[quad >> 24] & 0xFFFF0000);
+        output_words += 2;
+    }
+#else
+    // Two words per color: phases 0° and 90° for even pixels,
+    // 180° and 270° for odd pixels
+    const uint32_t *palette_even = (const uint32_t *) palette;
+    const uint32_t *palette_odd = palette_even + 1;
+
+    for (uint quads = pixel_count / 4; quads; quads--) {
+        const uint32_t quad = *pixel_quads++;
+        output_words[0] = palette_even[(quad & 0xFF) * 2];
+        output_words[1] = palette_odd[(quad >> 8 & 0xFF) * 2];
+        output_words[2] = palette_even[(quad >> 16 & 0xFF) * 2];
+        output_words[3] = palette_odd[(quad >> 24) * 2];
+        output_words += 4;
+    }
+#endif
+}
+#endif
+
+#if NTSC_PIXEL_BITS < 8
+/* ===========================================================================
+ * Function: ntsc_encode_packed_pixels
+ * Purpose: Encode a run of packed 4/2/1bpp pixels into NTSC samples
+ * Each 32-bit load yields 32 / NTSC_GROUP_BITS pixel groups, each group
+ * copies its NTSC_GROUP_UNITS units of samples from ntsc_group_palette.
+ * Every pixel word starts on phase 0, the group loop is unrolled so the
+ * phase half of each group is a constant.
+ * pixels must be 4-byte aligned and pixel_count fill whole words, groups is
+ * the row's table inside ntsc_group_palette
+ * =========================================================================== */
+static void __time_critical_func(ntsc_encode_packed_pixels)(ntsc_sample_t *output, const uint8_t *pixels, const uint pixel_count,
+                                                              const ntsc_group_table_t *groups) {
+    const uint32_t *pixel_words = (const uint32_t *) pixels;
+    ntsc_group_unit_t *output_units = (ntsc_group_unit_t *) output;
+
+    for (uint words = pixel_count * NTSC_PIXEL_BITS / 32; words; words--) {
+        uint32_t packed = *pixel_words++;
+        for (uint group = 0; group < 32 / NTSC_GROUP_BITS; group++) {
+            const ntsc_group_unit_t *entry = (*groups)[group % NTSC_GROUP_PHASES][packed & ((1u << NTSC_GROUP_BITS) - 1)];
+            packed >>= NTSC_GROUP_BITS;
+            for (uint unit = 0; unit < NTSC_GROUP_UNITS; unit++)
+                *output_units++ = entry[unit];
+        }
+    }
+}
+#endif
+
+#if NTSC_PIXEL_BITS == 16
+/* ===========================================================================
+ * Function: ntsc_rgb565_sample
+ * Purpose: Sample of one RGB565 color at a subcarrier phase
+ * =========================================================================== */
+static inline ntsc_sample_t ntsc_rgb565_sample(const int32_t (*high)[256], const int32_t (*low)[256],
+                                               const uint phase, const uint color) {
+    const int32_t level = high[phase][color >> 8] + low[phase][color & 0xFF];
+    return ntsc_rgb565_samples[level >> (NTSC_RGB565_SHIFT - NTSC_LEVEL_SHIFT)];
+}
+
+/* ===========================================================================
+ * Function: ntsc_encode_rgb565_pixels
+ * Purpose: Encode a run of RGB565 pixels into NTSC samples
+ * Each iteration covers one subcarrier cycle, so every table phase is a
+ * constant. pixels must be 2-byte aligned and pixel_count a multiple of 4,
+ * palette_line selects the tables of the row (see ntsc_palette_line())
+ * =========================================================================== */
+static void __time_critical_func(ntsc_encode_rgb565_pixels)(ntsc_sample_t *output, const uint8_t *pixels, const uint pixel_count,
+                                                              const uint palette_line) {
+    const uint16_t *colors = (const uint16_t *) pixels;
+    const int32_t (*high)[256] = ntsc_rgb565_high[palette_line];
+    const int32_t (*low)[256] = ntsc_rgb565_low[palette_line];
+
+#if NTSC_SAMPLES_PER_PIXEL == 1
+    for (uint pixel = 0; pixel < pixel_count; pixel += 4) {
+        output[0] = ntsc_rgb565_sample(high, low, 0, colors[0]);
+        output[1] = ntsc_rgb565_sample(high, low, 1, colors[1]);
+        output[2] = ntsc_rgb565_sample(high, low, 2, colors[2]);
+        output[3] = ntsc_rgb565_sample(high, low, 3, colors[3]);
+        colors += 4;
+        output += 4;
+    }
+#else
+    for (uint pixel = 0; pixel < pixel_count; pixel += 2) {
+        const uint even = colors[0];
+        const uint odd = colors[1];
+        output[0] = ntsc_rgb565_sample(high, low, 0, even);
+        output[1] = ntsc_rgb565_sample(high, low, 1, even);
+        output[2] = ntsc_rgb565_sample(high, low, 2, odd);
+        output[3] = ntsc_rgb565_sample(high, low, 3, odd);
+        colors += 2;
+        output += 4;
+    }
+#endif
+}
+#endif
+
+#if NTSC_PIXEL_BITS < 8
+/* ===========================================================================
+ * Function: ntsc_build_group
+ * Purpose: Fill one pixel group table entry from palette `line` of ntsc_palette
+ * =========================================================================== */
+static inline void ntsc_build_group(const uint line, const uint half, const uint group) {
+    const uint color_mask = (1u << NTSC_PIXEL_BITS) - 1;
+    const ntsc_sample_t *palette = ntsc_palette + line * NTSC_PALETTE_SIZE;
+
+    // Sample k of a group starting at phase 2 * half is at phase 2 * half + k
+    ntsc_sample_t *samples = (ntsc_sample_t *) ntsc_group_palette[line][half][group];
+    for (uint sample = 0; sample < NTSC_GROUP_SAMPLES; sample++) {
+        const uint pixel_color = group >> sample / NTSC_SAMPLES_PER_PIXEL * NTSC_PIXEL_BITS & color_mask;
+#if NTSC_ARTIFACT_COLOR
+        *samples++ = pixel_color ? NTSC_SAMPLE(NTSC_LEVEL(NTSC_ARTIFACT_WHITE)) : NTSC_SAMPLE(NTSC_LEVEL(NTSC_ARTIFACT_BLACK));
+#else
+        *samples++ = palette[pixel_color * 4 + (2 * half + sample) % 4];
+#endif
+    }
+}
+
+/* ===========================================================================
+ * Function: ntsc_update_group_palette
+ * Purpose: Refresh every pixel group table entry that contains a color
+ * =========================================================================== */
+static void ntsc_update_group_palette(const uint color) {
+    const uint color_mask = (1u << NTSC_PIXEL_BITS) - 1;
+    if (color > color_mask)
+        return;
+
+    for (uint group = 0; group < 1u << NTSC_GROUP_BITS; group++) {
+        bool contains_color = false;
+        for (uint pixel = 0; pixel < NTSC_GROUP_PIXELS; pixel++)
+            contains_color |= (group >> pixel * NTSC_PIXEL_BITS & color_mask) == color;
+        if (!contains_color)
+            continue;
+
+        for (uint line = 0; line < NTSC_PALETTE_LINES; line++)
+            for (uint half = 0; half < NTSC_GROUP_PHASES; half++)
+                ntsc_build_group(line, half, group);
+    }
+}
+
+/* ===========================================================================
+ * Function: ntsc_build_group_palette
+ * Purpose: Rebuild the whole pixel group table, one pass over all groups
+ * =========================================================================== */
+static void ntsc_build_group_palette() {
+    for (uint line = 0; line < NTSC_PALETTE_LINES; line++)
+        for (uint group = 0; group < 1u << NTSC_GROUP_BITS; group++)
+            for (uint half = 0; half < NTSC_GROUP_PHASES; half++)
+                ntsc_build_group(line, half, group);
+}
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_palette_changed
+ * Purpose: Bring the tables derived from ntsc_palette up to date after
+ *          `count` entries from `first` on changed
+ * =========================================================================== */
+static inline void ntsc_palette_changed(const uint first, const uint count) {
+#if NTSC_PIXEL_BITS < 8 && !NTSC_ARTIFACT_COLOR
+    if (count == 1)
+        ntsc_update_group_palette(first);
+    else if (first < 1u << NTSC_PIXEL_BITS)
+        ntsc_build_group_palette();
+#else
+    // No pixel group table in this pixel format
+    (void) first;
+    (void) count;
+#endif
+#if NTSC_LINE_CACHE
+    // Any row may use the colors
+    for (uint row = 0; row < NTSC_FRAME_HEIGHT; row++)
+        ntsc_dirty_rows[row] = 1;
+#endif
+}
+
+/* ===========================================================================
+ * Sprites
+ * =========================================================================== */
+
+// Sprites composited over the active video, 0 disables the sprite layer
+#ifndef NTSC_SPRITE_COUNT
+#define NTSC_SPRITE_COUNT 0
+#endif
+
+#if NTSC_SPRITE_COUNT
+// Sprites drawn on one line at most, further sprites are dropped on that line
+#ifndef NTSC_SPRITES_PER_LINE
+#define NTSC_SPRITES_PER_LINE 8
+#endif
+
+_Static_assert(NTSC_SPRITE_COUNT <= 256, "Sprite lists hold 8-bit sprite indices");
+// Sprite pixels are palette indices, drawn as the palette's samples
+#if NTSC_PIXEL_BITS == 16 || NTSC_ARTIFACT_COLOR
+#error "NTSC_SPRITE_COUNT draws through ntsc_palette, it can't be used with NTSC_PIXEL_BITS=16 or NTSC_ARTIFACT_COLOR"
+#endif
+
+typedef struct {
+    const uint8_t *pixels;          // width * height 8bpp pixels, row by row, NULL hides the sprite
+    int16_t x, y;                   // Top left corner in pixels, may lie off screen
+    uint8_t width, height;          // Size in pixels
+    uint8_t transparent;            // Color index that is not drawn
+    uint8_t palette_offset;         // Added to every drawn color index
+} ntsc_sprite_t;
+
+// Sprite attributes written by the application, picked up at the next
+// vertical blanking, so a sprite never moves in the middle of a frame
+// Sprite 0 is drawn on top
+// Keep sprite pixels in RAM like the framebuffer, they are read by the video core
+static ntsc_sprite_t ntsc_sprites[NTSC_SPRITE_COUNT];
+
+// Snapshot of ntsc_sprites for the frame being scanned out
+static ntsc_sprite_t ntsc_sprites_shown[NTSC_SPRITE_COUNT];
+
+// Per-line sprite lists of the frame being scanned out, in priority order
+static uint8_t ntsc_sprite_lines[NTSC_FRAME_HEIGHT][NTSC_SPRITES_PER_LINE];
+static uint8_t ntsc_sprite_line_count[NTSC_FRAME_HEIGHT];
+
+#if NTSC_SAMPLES_PER_PIXEL == 2
+// Two samples at one pixel's subcarrier phase
+#if NTSC_SAMPLE_BITS == 8
+typedef uint16_t ntsc_sample_pair_t;
+#else
+typedef uint32_t ntsc_sample_pair_t;
+#endif
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_build_sprite_lines
+ * Purpose: Snapshot the sprites and sort them into per-line lists, called
+ * during vertical blanking
+ * =========================================================================== */
+static inline void ntsc_build_sprite_lines() {
+    for (uint row = 0; row < NTSC_FRAME_HEIGHT; row++) {
+#if NTSC_LINE_CACHE
+        // Cached rows keep the sprites they were encoded with, rows with
+        // sprites last frame or this frame are encoded again
+        if (ntsc_sprite_line_count[row])
+            ntsc_dirty_rows[row] = 1;
+#endif
+        ntsc_sprite_line_count[row] = 0;
+    }
+
+    for (uint index = 0; index < NTSC_SPRITE_COUNT; index++) {
+        const ntsc_sprite_t sprite = ntsc_sprites[index];
+        ntsc_sprites_shown[index] = sprite;
+
+        if (!sprite.pixels || sprite.x >= NTSC_FRAME_WIDTH || sprite.x + sprite.width <= 0)
+            continue;
+
+        const int first_row = MAX(sprite.y, 0);
+        const int end_row = MIN(sprite.y + sprite.height, NTSC_FRAME_HEIGHT);
+        for (int row = first_row; row < end_row; row++) {
+            if (ntsc_sprite_line_count[row] < NTSC_SPRITES_PER_LINE)
+                ntsc_sprite_lines[row][ntsc_sprite_line_count[row]++] = index;
+#if NTSC_LINE_CACHE
+            ntsc_dirty_rows[row] = 1;
+#endif
+        }
+    }
+}
+
+/* ===========================================================================
+ * Function: ntsc_draw_sprites
+ * Purpose: Composite the sprites of one row over its encoded active video
+ * Opaque sprite pixels overwrite their samples with the palette entries
+ * at the pixel's subcarrier phase, lowest priority first
+ * =========================================================================== */
+static void __time_critical_func(ntsc_draw_sprites)(ntsc_sample_t *output, const uint row) {
+    const ntsc_sample_t *palette = ntsc_palette + ntsc_palette_line(row) * NTSC_PALETTE_SIZE;
+
+    for (uint i = ntsc_sprite_line_count[row]; i--;) {
+        const ntsc_sprite_t *sprite = &ntsc_sprites_shown[ntsc_sprite_lines[row][i]];
+        const uint8_t *pixels = sprite->pixels + (row - sprite->y) * sprite->width;
+
+        // Sprite columns inside the frame
+        const int first_column = MAX(-sprite->x, 0);
+        const int end_column = MIN(NTSC_FRAME_WIDTH - sprite->x, sprite->width);
+
+        for (int column = first_column; column < end_column; column++) {
+            const uint8_t color = pixels[column];
+            if (color == sprite->transparent)
+                continue;
+            const uint x = sprite->x + column;
+            const uint8_t shown_color = color + sprite->palette_offset;
+#if NTSC_SAMPLES_PER_PIXEL == 1
+            output[x] = palette[shown_color * 4 + x % 4];
+#else
+            *(ntsc_sample_pair_t *) (output + x * 2) = *(const ntsc_sample_pair_t *) (palette + shown_color * 4 + (x & 1) * 2);
+#endif
+        }
+    }
+}
+#endif
+
+#if NTSC_SCROLL
+/* ===========================================================================
+ * Function: ntsc_scrolled_row
+ * Purpose: Pixels of viewport row `row` at scroll position `scroll`
+ * Returns the framebuffer row itself when the viewport row is word aligned
+ * and does not wrap, otherwise the row gathered into ntsc_scroll_line
+ * =========================================================================== */
+static inline const uint8_t *ntsc_scrolled_row(const uint row, const ntsc_scroll_t scroll) {
+    const uint8_t *virtual_row = ntsc_display_buffer + (row + scroll.y) % NTSC_VIRTUAL_HEIGHT * NTSC_VIRTUAL_ROW_BYTES;
+    const uint offset = scroll.x % NTSC_VIRTUAL_WIDTH * NTSC_PIXEL_BITS / 8;
+
+    if (offset % 4 == 0 && offset + NTSC_FRAME_ROW_BYTES <= NTSC_VIRTUAL_ROW_BYTES)
+        return virtual_row + offset;
+
+    const uint head = MIN(NTSC_VIRTUAL_ROW_BYTES - offset, NTSC_FRAME_ROW_BYTES);
+    memcpy(ntsc_scroll_line, virtual_row + offset, head);
+    memcpy(ntsc_scroll_line + head, virtual_row, NTSC_FRAME_ROW_BYTES - head);
+    return ntsc_scroll_line;
+}
+#endif
+
+#if NTSC_STREAM_INPUT
+// Channel receiving lines for ntsc_stream_start_dma(), and whether it
+// stopped on a full ring and waits for the video core to free a line.
+// The lock makes stopping on a full ring and freeing a line one step each,
+// so a line freed while the channel stops can't go unnoticed. NULL while
+// the ring isn't fed by DMA
+static uint ntsc_stream_dma_chan;
+static volatile bool ntsc_stream_dma_waiting;
+static spin_lock_t *ntsc_stream_dma_lock;
+
+/* ===========================================================================
+ * Function: ntsc_stream_acquire
+ * Purpose: Line buffer for the producer to fill next
+ * Returns NULL while the ring is full. The producer fills the row number
+ * and the pixels and passes the line on with ntsc_stream_commit()
+ * =========================================================================== */
+static inline ntsc_stream_line_t *ntsc_stream_acquire() {
+    if (ntsc_stream_write - ntsc_stream_read >= NTSC_STREAM_LINES - 1)
+        return NULL;
+    return &ntsc_stream_lines[ntsc_stream_write % NTSC_STREAM_LINES];
+}
+
+/* ===========================================================================
+ * Function: ntsc_stream_commit
+ * Purpose: Queue the line from ntsc_stream_acquire() for the video core
+ * Lines are expected in scan order, rows that are already past when their
+ * line is reached are dropped
+ * =========================================================================== */
+static inline void ntsc_stream_commit() {
+    __dmb();
+    ntsc_stream_write++;
+}
+
+/* ===========================================================================
+ * Function: ntsc_stream_dma_receive
+ * Purpose: Point the stream DMA channel at the next free line and start it,
+ *          or leave it stopped until the video core frees one
+ * Stopping is the backpressure: the source's FIFO fills and its flow
+ * control (SPI chip select, UART RTS, a PIO handshake) holds the host off.
+ * Called with ntsc_stream_dma_lock held, while the channel is stopped
+ * =========================================================================== */
+static void __time_critical_func(ntsc_stream_dma_receive)() {
+    ntsc_stream_line_t *line = ntsc_stream_acquire();
+    ntsc_stream_dma_waiting = !line;
+    if (line)
+        dma_channel_set_write_addr(ntsc_stream_dma_chan, line, true);
+}
+
+/* ===========================================================================
+ * Function: ntsc_stream_position
+ * Purpose: Position of framebuffer row `row` in the scan order of a frame,
+ *          the rows of both fields in turn when interlaced
+ * =========================================================================== */
+static inline uint ntsc_stream_position(const uint row) {
+    return (NTSC_FIELDS - 1 - row % NTSC_FIELDS) * NTSC_FIELD_ROWS + row / NTSC_FIELDS;
+}
+
+/* ===========================================================================
+ * Function: ntsc_stream_release
+ * Purpose: Free the lines before line `read` for the producer, and restart
+ *          the stream DMA channel if it stopped on the full ring
+ * =========================================================================== */
+static inline void ntsc_stream_release(const uint32_t read) {
+    if (!ntsc_stream_dma_lock) {
+        ntsc_stream_read = read;
+        return;
+    }
+    const uint32_t save = spin_lock_blocking(ntsc_stream_dma_lock);
+    ntsc_stream_read = read;
+    if (ntsc_stream_dma_waiting)
+        ntsc_stream_dma_receive();
+    spin_unlock(ntsc_stream_dma_lock, save);
+}
+
+/* ===========================================================================
+ * Function: ntsc_stream_row
+ * Purpose: Pixels of framebuffer row `row`, straight from the line ring
+ * Lines for rows already past are dropped. Without a line for the row,
+ * the pixels last shown are shown again and counted as an underrun
+ * =========================================================================== */
+static inline const uint8_t *ntsc_stream_row(const uint row) {
+    const uint position = ntsc_stream_position(row);
+    const uint32_t write = ntsc_stream_write;
+    uint32_t read = ntsc_stream_read;
+    const uint8_t *pixels = NULL;
+
+    while (read != write) {
+        const ntsc_stream_line_t *line = &ntsc_stream_lines[read % NTSC_STREAM_LINES];
+        // Rows up to half a frame ahead are early, anything else is late
+        const uint ahead = (ntsc_stream_position(line->row) + NTSC_FRAME_HEIGHT - position) % NTSC_FRAME_HEIGHT;
+        if (line->row < NTSC_FRAME_HEIGHT && ahead && ahead < NTSC_FRAME_HEIGHT / 2)
+            break;
+        read++;
+        if (line->row < NTSC_FRAME_HEIGHT && !ahead) {
+            pixels = line->pixels;
+            break;
+        }
+        ntsc_stream_dropped++;
+    }
+    if (read == ntsc_stream_read) {
+        ntsc_stream_underruns++;
+        return ntsc_stream_lines[(read - 1) % NTSC_STREAM_LINES].pixels;
+    }
+    if (!pixels) {
+        // Only late lines were taken: carry the pixels last shown over into
+        // the last of them, which becomes the line held for repeats, while
+        // both are still held
+        uint8_t *held = ntsc_stream_lines[(read - 1) % NTSC_STREAM_LINES].pixels;
+        memcpy(held, ntsc_stream_lines[(ntsc_stream_read - 1) % NTSC_STREAM_LINES].pixels, NTSC_FRAME_ROW_BYTES);
+        ntsc_stream_underruns++;
+        pixels = held;
+    }
+    ntsc_stream_release(read);
+    return pixels;
+}
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_encode_row
+ * Purpose: Encode one framebuffer row into NTSC_ACTIVE_SAMPLES samples, the
+ *          first one at subcarrier phase 0
+ * =========================================================================== */
+static inline void ntsc_encode_row(ntsc_sample_t *output, const uint row) {
+#if NTSC_TILE_MODE
+    // Gather the pattern row of every tile on this line, two words per tile
+    const uint8_t *map_row = ntsc_tile_map + row / NTSC_TILE_SIZE * NTSC_TILE_COLUMNS;
+    const uint pattern_offset = row % NTSC_TILE_SIZE * NTSC_TILE_SIZE;
+    uint32_t *line_words = (uint32_t *) ntsc_tile_line;
+
+    for (uint column = 0; column < NTSC_TILE_COLUMNS; column++) {
+        const uint32_t *pattern_row = (const uint32_t *) (ntsc_tile_patterns[map_row[column]] + pattern_offset);
+        *line_words++ = pattern_row[0];
+        *line_words++ = pattern_row[1];
+    }
+    const uint8_t *pixels = ntsc_tile_line;
+#elif NTSC_LINE_CALLBACK
+    const ntsc_line_callback_t callback = ntsc_line_callback;
+    if (callback)
+        callback(row, ntsc_callback_line);
+    const uint8_t *pixels = ntsc_callback_line;
+#elif NTSC_STREAM_INPUT
+    const uint8_t *pixels = ntsc_stream_row(row);
+#elif NTSC_SCROLL == 2
+    const uint8_t *pixels = ntsc_scrolled_row(row, ntsc_line_scroll_shown[row]);
+#elif NTSC_SCROLL
+    const uint8_t *pixels = ntsc_scrolled_row(row, ntsc_scroll_shown);
+#else
+    const uint8_t *pixels = ntsc_display_buffer + row * NTSC_VIRTUAL_ROW_BYTES;
+#endif
+    // The palette of the row's line parity, a constant without PAL
+    const uint palette_line = ntsc_palette_line(row);
+#if NTSC_PIXEL_BITS == 16
+    ntsc_encode_rgb565_pixels(output, pixels, NTSC_FRAME_WIDTH, palette_line);
+#elif NTSC_PIXEL_BITS < 8
+    ntsc_encode_packed_pixels(output, pixels, NTSC_FRAME_WIDTH, &ntsc_group_palette[palette_line]);
+#else
+    ntsc_encode_pixels(output, pixels, NTSC_FRAME_WIDTH, ntsc_palette + palette_line * NTSC_PALETTE_SIZE);
+#endif
+#if NTSC_SPRITE_COUNT
+    ntsc_draw_sprites(output, row);
+#endif
+}
+
+/* ===========================================================================
+ * Function: ntsc_encode_active_line
+ * Purpose: Encode one framebuffer row into the active video window of a scanline
+ * =========================================================================== */
+static inline void ntsc_encode_active_line(ntsc_sample_t *output_buffer, const uint row) {
+    // Skip horizontal blanking interval, it is already in the buffer
+    ntsc_encode_row(output_buffer + NTSC_ACTIVE_START, row);
+}
+
+/* ===========================================================================
+ * Function: ntsc_end_of_frame
+ * Purpose: Vertical blanking work, called once the last visible row is encoded
+ * The front page is no longer read at this point and can be flipped
+ * =========================================================================== */
+static inline void ntsc_end_of_frame() {
+#if NTSC_DOUBLE_BUFFER
+    if (ntsc_swap_pending) {
+        uint8_t *const shown_page = (uint8_t *) ntsc_display_buffer;
+        ntsc_display_buffer = ntsc_framebuffer;
+        ntsc_framebuffer = shown_page;
+        ntsc_swap_pending = false;
+    }
+#endif
+#if NTSC_DOUBLE_PALETTE
+    if (ntsc_palette_commit_pending) {
+        memcpy(ntsc_palette, ntsc_back_palette, sizeof(ntsc_palette));
+        ntsc_palette_changed(0, 256);
+        ntsc_palette_commit_pending = false;
+    }
+#endif
+#if NTSC_SCROLL == 2
+    memcpy(ntsc_line_scroll_shown, ntsc_line_scroll, sizeof(ntsc_line_scroll));
+#elif NTSC_SCROLL
+    ntsc_scroll_shown = ntsc_scroll;
+#endif
+#if NTSC_SPRITE_COUNT
+    ntsc_build_sprite_lines();
+#endif
+#if NTSC_STATS
+    ntsc_stats_end_of_frame();
+#endif
+    const uint32_t frame = ++ntsc_frame_counter;
+    // Cleared after the count, so a 0 read before ntsc_frame_counter sees
+    // this field's count (ntsc_wait_frame_start())
+    ntsc_is_rendering_active = 0;
+
+    const ntsc_vblank_callback_t callback = ntsc_vblank_callback;
+    if (callback)
+        callback(frame);
+
+    // Wake up both cores from ntsc_wait_vsync()
+    __sev();
+}
+
+#if NTSC_DMA_ENGINE == NTSC_DMA_PINGPONG
+// Samples of the scanline queued last, it is on air while the next
+// scanline is generated
+static const ntsc_sample_t *ntsc_queued_scanline;
+
+// Scanline the next DMA interrupt generates, lines 0 and 1 are queued by
+// ntsc_init()
+static volatile uint ntsc_next_scanline = 2;
+
+/* ===========================================================================
+ * Function: ntsc_generate_scanline
+ * Purpose: Generate NTSC composite video signal data for one scanline
+ * Returns the samples to transmit: a scanline buffer with a freshly
+ * encoded active line, the previous scanline again for a repeated row, or
+ * one of the precomputed sync/blanking templates
+ * New rows are encoded into the scanline buffer that is not on air, both
+ * DMA channels may send the same buffer once rows repeat
+ * =========================================================================== */
+static inline const ntsc_sample_t *ntsc_generate_scanline(const size_t scanline_number) {
+    const ntsc_sample_t *scanline = ntsc_vsync_template(scanline_number);
+    const uint field = ntsc_field_of_line(scanline_number);
+    const uint field_line = scanline_number - field * NTSC_FIELD_LINES;
+
+    if (scanline) {
+        // Vertical sync pulses
+    } else if (field_line < NTSC_ACTIVE_FIRST_LINE || field_line >= NTSC_ACTIVE_END_LINE) {
+        // Blanking lines before and after active video
+        // Mark end of active video on first blanking line
+        if (field_line == NTSC_ACTIVE_END_LINE)
+            ntsc_end_of_frame();
+        scanline = ntsc_blank_template(scanline_number);
+    } else {
+        const uint active_line = field_line - NTSC_ACTIVE_FIRST_LINE;
+        if (active_line == 0)
+            ntsc_is_rendering_active = 1;
+        if (active_line % NTSC_LINE_REPEAT) {
+            // Repeated row, send the samples of the line on air again
+            scanline = ntsc_queued_scanline;
+        } else {
+            // Active video scanline
+#if NTSC_PAL
+            // The buffer of the line's parity carries its burst, rows never
+            // repeat so the other buffer is the one on air
+            ntsc_sample_t *output_buffer = ntsc_scanline_buffers[scanline_number & 1];
+#else
+            ntsc_sample_t *output_buffer = ntsc_queued_scanline == ntsc_scanline_buffers[0] ?
+                                           ntsc_scanline_buffers[1] : ntsc_scanline_buffers[0];
+#endif
+            ntsc_encode_active_line(output_buffer, NTSC_FIELD_ROW(field, active_line / NTSC_LINE_REPEAT));
+            scanline = output_buffer;
+        }
+    }
+
+    ntsc_queued_scanline = scanline;
+    return scanline;
+}
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_wait_vsync
+ * Purpose: Block until the next vertical blanking interval begins
+ * The core sleeps in WFE in between, the video core sends an event (SEV)
+ * once per frame, other events only cost another check
+ * =========================================================================== */
+static inline void ntsc_wait_vsync() {
+    const uint32_t frame = ntsc_frame_counter;
+    while (ntsc_frame_counter == frame)
+        __wfe();
+}
+
+/* ===========================================================================
+ * Function: ntsc_set_vblank_callback
+ * Purpose: Install the callback run at the start of every vertical blanking
+ * interval, NULL removes it
+ * =========================================================================== */
+static inline void ntsc_set_vblank_callback(const ntsc_vblank_callback_t callback) {
+    ntsc_vblank_callback = callback;
+}
+
+#if NTSC_DOUBLE_BUFFER
+/* ===========================================================================
+ * Function: ntsc_swap_buffers
+ * Purpose: Queue a page flip for the next vertical blanking interval
+ * The flip happens after the last visible row of the current frame has been
+ * read, ntsc_framebuffer then points to the page that was displayed before.
+ * Call ntsc_wait_vsync() before drawing into ntsc_framebuffer again.
+ * =========================================================================== */
+static inline void ntsc_swap_buffers() {
+    ntsc_swap_pending = true;
+}
+#endif
+
+#if NTSC_LINE_CALLBACK
+/* ===========================================================================
+ * Function: ntsc_set_line_callback
+ * Purpose: Install the callback that provides the pixels of every row
+ * Takes effect from the next row encoded, NULL keeps showing the last row
+ * the previous callback filled
+ * =========================================================================== */
+static inline void ntsc_set_line_callback(const ntsc_line_callback_t callback) {
+    ntsc_line_callback = callback;
+}
+#endif
+
+#if NTSC_STREAM_INPUT
+/* ===========================================================================
+ * Function: ntsc_stream_dma_irq_handler
+ * Purpose: Commit the line the stream DMA channel has received and start
+ *          receiving the next one
+ * =========================================================================== */
+static void __time_critical_func(ntsc_stream_dma_irq_handler)() {
+    const uint32_t channel_bit = 1u << ntsc_stream_dma_chan;
+    if (!(NTSC_STREAM_DMA_INTS & channel_bit))
+        return;
+    NTSC_STREAM_DMA_INTS = channel_bit;
+    const uint32_t save = spin_lock_blocking(ntsc_stream_dma_lock);
+    ntsc_stream_commit();
+    ntsc_stream_dma_receive();
+    spin_unlock(ntsc_stream_dma_lock, save);
+}
+
+/* ===========================================================================
+ * Function: ntsc_stream_start_dma
+ * Purpose: Receive lines into the ring by DMA from a peripheral FIFO
+ * `source` is the FIFO register (e.g. &spi_get_hw(spi0)->dr or a PIO RX
+ * FIFO), `dreq` its pacing signal and `size` its transfer width. Every line
+ * is sizeof(ntsc_stream_line_t) bytes on the wire, header first, and each
+ * one lands in its line buffer with no copy. The completion interrupt runs
+ * on the calling core
+ * =========================================================================== */
+static void ntsc_stream_start_dma(const volatile void *source, const uint dreq, const enum dma_channel_transfer_size size) {
+    _Static_assert(sizeof(ntsc_stream_line_t) % 4 == 0, "Stream lines must be a whole number of words");
+    ntsc_stream_dma_chan = dma_claim_unused_channel(true);
+
+    dma_channel_config cfg = dma_channel_get_default_config(ntsc_stream_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, size);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, dreq);
+    dma_channel_configure(ntsc_stream_dma_chan, &cfg, NULL, source, sizeof(ntsc_stream_line_t) >> size, false);
+
+    irq_add_shared_handler(NTSC_STREAM_DMA_IRQ, ntsc_stream_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_irqn_set_channel_mask_enabled(1 - NTSC_DMA_IRQ_INDEX, 1u << ntsc_stream_dma_chan, true);
+    irq_set_enabled(NTSC_STREAM_DMA_IRQ, true);
+
+    spin_lock_t *lock = spin_lock_instance(spin_lock_claim_unused(true));
+    const uint32_t save = spin_lock_blocking(lock);
+    ntsc_stream_dma_lock = lock;
+    ntsc_stream_dma_receive();
+    spin_unlock(lock, save);
+}
+#endif
+
+#if NTSC_HAS_FRAMEBUFFER
+/* ===========================================================================
+ * Function: ntsc_put_pixel
+ * Purpose: Draw one pixel into ntsc_framebuffer in any pixel format, at
+ *          framebuffer (not viewport) coordinates
+ * color is a palette index, or an RGB565 color at 16bpp
+ * =========================================================================== */
+static inline void ntsc_put_pixel(const uint x, const uint y, const uint16_t color) {
+#if NTSC_PIXEL_BITS == 16
+    ((uint16_t *) ntsc_framebuffer)[y * NTSC_VIRTUAL_WIDTH + x] = color;
+#elif NTSC_PIXEL_BITS == 8
+    ntsc_framebuffer[y * NTSC_VIRTUAL_ROW_BYTES + x] = color;
+#else
+    uint8_t *byte = &ntsc_framebuffer[y * NTSC_VIRTUAL_ROW_BYTES + x * NTSC_PIXEL_BITS / 8];
+    const uint shift = x * NTSC_PIXEL_BITS % 8;
+    const uint8_t mask = ((1u << NTSC_PIXEL_BITS) - 1) << shift;
+    *byte = (*byte & ~mask) | (color << shift & mask);
+#endif
+#if NTSC_LINE_CACHE
+    ntsc_dirty_rows[y] = 1;
+#endif
+}
+
+#if NTSC_ARTIFACT_COLOR
+/* ===========================================================================
+ * Function: ntsc_put_artifact_cell
+ * Purpose: Draw the 4 pixels of artifact color cell `cell` of row y, bit k
+ *          of pattern is pixel 4 * cell + k
+ * At NTSC_FRAME_WIDTH 640 a cell is one subcarrier cycle: 0x0 black, 0xF
+ * white, 0x3, 0x6, 0xC and 0x9 four hues 90° apart, 0x1, 0x2, 0x4 and 0x8
+ * dark hues on the phases in between, 0xE, 0xD, 0xB and 0x7 light hues
+ * opposite those, 0x5 and 0xA a middle gray
+ * =========================================================================== */
+static inline void ntsc_put_artifact_cell(const uint cell, const uint y, const uint8_t pattern) {
+    uint8_t *byte = &ntsc_framebuffer[y * NTSC_VIRTUAL_ROW_BYTES + cell / 2];
+    const uint shift = cell % 2 * 4;
+    *byte = (*byte & ~(0xF << shift)) | (pattern & 0xF) << shift;
+#if NTSC_LINE_CACHE
+    ntsc_dirty_rows[y] = 1;
+#endif
+}
+#endif
+#endif
 
-// NTSC composite video signal levels (0-7 range for 3-bit PWM)
-#define NTSC_LEVEL_SYNC          0    // Sync pulse level (lowest)
-#define NTSC_LEVEL_BLANK         2    // Blanking/black level
-#define NTSC_LEVEL_BLACK         2    // Black level (same as blanking)
-#define NTSC_LEVEL_BURST_LOW     1    // Color burst low level
-#define NTSC_LEVEL_BURST_HIGH    3    // Color burst high level
+#if NTSC_LINE_CACHE
+/* ===========================================================================
+ * Function: ntsc_mark_dirty
+ * Purpose: Queue rows y0 up to y1 (exclusive) to be encoded again
+ * Needed after writing to ntsc_framebuffer, the tile map or the tile
+ * patterns directly, ntsc_put_pixel() and ntsc_set_color() mark their rows
+ * themselves. Rows are encoded during the next vertical blanking
+ * intervals, NTSC_CACHE_ROWS_PER_FRAME at a time.
+ * =========================================================================== */
+static inline void ntsc_mark_dirty(const uint y0, const uint y1) {
+    for (uint row = y0; row < y1 && row < NTSC_FRAME_HEIGHT; row++)
+        ntsc_dirty_rows[row] = 1;
+}
+#endif
 
+#if NTSC_PHASE_DITHER
 /* ===========================================================================
- * Hardware Pin Configuration
+ * Function: ntsc_fit_phases
+ * Purpose: Fit the samples of one color to the output levels (see
+ * NTSC_PHASE_DITHER), signal holds the exact levels at the 4 phases in
+ * 1/65536 output levels
+ * Of the 16 ways to round the samples up or down, the one with the least
+ * 4 * luma error^2 + chroma error^2 is taken: with rounding errors e0..e3
+ * that is (e0 + e1 + e2 + e3)^2 + (e0 - e2)^2 + (e1 - e3)^2, e0 - e1 + e2 - e3
+ * being the invisible 2x subcarrier part
  * =========================================================================== */
+static void ntsc_fit_phases(const int32_t signal[4], ntsc_sample_t *samples) {
+    const int32_t level_max = NTSC_LEVEL_MAX * 65536;
+    const int32_t luma = MIN(MAX((signal[0] + signal[1] + signal[2] + signal[3]) / 4, 0), level_max);
 
-// Pin for NTSC composite video signal output via PWM
-#ifndef NTSC_PIN_OUTPUT
-#define NTSC_PIN_OUTPUT 27
+    // Scale the chroma down until the peaks fit between 0 and NTSC_LEVEL_MAX
+    int32_t peak = luma, trough = luma;
+    for (uint phase = 0; phase < 4; phase++) {
+        peak = MAX(peak, signal[phase]);
+        trough = MIN(trough, signal[phase]);
+    }
+    int64_t gain_num = 1, gain_den = 1;
+    if (peak > level_max) {
+        gain_num = level_max - luma;
+        gain_den = peak - luma;
+    }
+    if (trough < 0 && (int64_t) luma * gain_den < (int64_t) (luma - trough) * gain_num) {
+        gain_num = luma;
+        gain_den = luma - trough;
+    }
+
+    int32_t floor_level[4], error_down[4]; // Rounding down error, in 1/256 levels
+    for (uint phase = 0; phase < 4; phase++) {
+        const int32_t fitted = luma + (int32_t) ((signal[phase] - luma) * gain_num / gain_den);
+        floor_level[phase] = fitted >> 16;
+        error_down[phase] = -((fitted & 0xFFFF) >> 8);
+    }
+
+    uint best_mask = 0;
+    int32_t best_cost = INT32_MAX;
+    for (uint mask = 0; mask < 16; mask++) {
+        int32_t error[4];
+        for (uint phase = 0; phase < 4; phase++)
+            error[phase] = error_down[phase] + (mask >> phase & 1 ? 256 : 0);
+        const int32_t luma_error = error[0] + error[1] + error[2] + error[3];
+        const int32_t cost = luma_error * luma_error + (error[0] - error[2]) * (error[0] - error[2]) +
+                             (error[1] - error[3]) * (error[1] - error[3]);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_mask = mask;
+        }
+    }
+
+    for (uint phase = 0; phase < 4; phase++)
+        samples[phase] = NTSC_SAMPLE(MIN(MAX(floor_level[phase] + (int32_t) (best_mask >> phase & 1), 0), NTSC_LEVEL_MAX));
+}
 #endif
 
-// Graphics framebuffer - stores raw pixel data for the display
-// Aligned to the 4-byte boundary for efficient DMA transfers
-static uint8_t ntsc_framebuffer[NTSC_FRAME_WIDTH * NTSC_FRAME_HEIGHT] __attribute__ ((aligned (4)));
+/* ===========================================================================
+ * Function: ntsc_set_color
+ * Purpose: Configure a color palette entry for NTSC encoding
+ * =========================================================================== */
+static void ntsc_set_color(const uint8_t palette_index, const uint8_t blue, const uint8_t red, const uint8_t green) {
+    // Calculate NTSC luminance using standard weights
+    const int32_t luminance = NTSC_LUMINANCE(blue, red, green);
 
-#if !NDEBUG
-// Flag indicating active video region processing
-//  1: Currently generating visible scanlines
-//  0: In a vertical blanking interval
-static volatile uint8_t ntsc_is_rendering_active;
+    // Generate composite signal values for each subcarrier phase, in each palette
+    for (uint line = 0; line < NTSC_PALETTE_LINES; line++) {
+        ntsc_sample_t *entry = &ntsc_edit_palette[line * NTSC_PALETTE_SIZE + palette_index * 4];
+#if NTSC_PHASE_DITHER
+        int32_t signal[4];
+#endif
+        for (uint phase = 0; phase < 4; phase++) {
+            const int32_t composite_signal = NTSC_COMPOSITE_SIGNAL(luminance, blue, red, ntsc_chroma_weights[line][phase][0],
+                                                                   ntsc_chroma_weights[line][phase][1]);
+#if NTSC_PHASE_DITHER
+            signal[phase] = composite_signal;
+#else
+            entry[phase] = NTSC_SIGNAL_SAMPLE(composite_signal);
+#endif
+        }
+#if NTSC_PHASE_DITHER
+        ntsc_fit_phases(signal, entry);
+#endif
+    }
 
-// Frame counter - increments after each complete frame
-// Application code should reset this to track frame timing
-static volatile uint16_t ntsc_frame_counter = 0;
+#if !NTSC_DOUBLE_PALETTE
+    ntsc_palette_changed(palette_index, 1);
 #endif
-// Ping-pong buffers for DMA double-buffering
-// While one buffer is being transmitted, the other is prepared
-// Size aligned to the 4-byte boundary for DMA efficiency
-static uint16_t ntsc_scanline_buffers[2][NTSC_SAMPLES_PER_LINE + 3 & ~3u] __attribute__ ((aligned (4)));
+}
 
-// NTSC color palette lookup table
-// Each color has 4 entries for the 4 phases of NTSC color subcarrier (0°, 90°, 180°, 270°)
-// This allows proper color encoding at 3.579545 MHz
-static uint16_t ntsc_palette[4 * 256] __attribute__ ((aligned (4)));
+/* ===========================================================================
+ * Function: ntsc_set_rgb332_palette
+ * Purpose: Load the palette with the RGB332 colors, so 8bpp pixels are
+ *          true color RRRGGGBB bytes (see NTSC_RGB332())
+ * =========================================================================== */
+static void ntsc_set_rgb332_palette() {
+    for (uint color = 0; color < 256; color++) {
+        const uint red = color >> 5, green = color >> 2 & 7, blue = color & 3;
+        ntsc_set_color(color, blue * 255 / 3, red * 255 / 7, green * 255 / 7);
+    }
+}
 
-// DMA channel handles for ping-pong operation
-static uint ntsc_dma_chan_primary, ntsc_dma_chan_secondary;
+#if NTSC_PIXEL_BITS == 16
+/* ===========================================================================
+ * Function: ntsc_rgb565_signal
+ * Purpose: Composite signal of 8-bit color components at one phase without
+ *          its constant offset, in 1/2^24 levels
+ * The ntsc_set_color() formula with the luminance kept in 1/256 units
+ * instead of being rounded, so the signal adds up over components
+ * =========================================================================== */
+static int32_t ntsc_rgb565_signal(const uint line, const uint phase, const int32_t blue, const int32_t red, const int32_t green) {
+    const int32_t luminance = 150 * green + 29 * blue + 77 * red; // Y * 256
+    return luminance * 1792 + (blue * 256 - luminance) * ntsc_chroma_weights[line][phase][0] +
+           (red * 256 - luminance) * ntsc_chroma_weights[line][phase][1];
+}
 
 /* ===========================================================================
- * Function: ntsc_generate_scanline
- * Purpose: Generate NTSC composite video signal data for one scanline
+ * Function: ntsc_build_rgb565_tables
+ * Purpose: Build the RGB565 component tables, called by ntsc_init()
  * =========================================================================== */
-static inline void ntsc_generate_scanline(uint16_t *output_buffer, const size_t scanline_number) {
-    // Static pointer maintains position between function calls
-    static uint8_t *current_pixel_ptr = ntsc_framebuffer;
-
-    uint16_t *buffer_ptr = output_buffer;
-
-    // Generate equalizing pulses for the first two scanlines
-    if (scanline_number < 2) {
-        // Fill most of the line with sync level (black)
-        for (int j = 0; j < NTSC_SAMPLES_PER_LINE - NTSC_HSYNC_WIDTH; j++)
-            *buffer_ptr++ = NTSC_LEVEL_SYNC;
-
-        // Add horizontal sync pulse at the end
-        while (buffer_ptr < output_buffer + NTSC_SAMPLES_PER_LINE)
-            *buffer_ptr++ = NTSC_LEVEL_BLANK;
-    }
-    // Generate vertical sync pulses
-    else if (scanline_number == NTSC_VSYNC_LINES || scanline_number == NTSC_VSYNC_LINES + 1) {
-        // Horizontal sync pulse
-        for (int j = 0; j < NTSC_HSYNC_WIDTH; j++)
-            *buffer_ptr++ = NTSC_LEVEL_SYNC;
-
-        // Back porch before color burst
-        for (int j = 0; j < 8; j++)
-            *buffer_ptr++ = NTSC_LEVEL_BLANK;
-
-        // Color burst signal - 9 cycles at 3.579545 MHz
-        // Alternates between levels to create a reference signal for color decoding
-        for (int j = 0; j < 9; j++) {
-            *buffer_ptr++ = 2; // Phase 0°
-            *buffer_ptr++ = 1; // Phase 90°
-            *buffer_ptr++ = 2; // Phase 180°
-            *buffer_ptr++ = 3; // Phase 270°
+static void ntsc_build_rgb565_tables() {
+    // Level offset, output rounding and bias, counted once in the low byte
+    // table, the rounding is half an output level
+    const int32_t offset = 2 * 65536 * 256 + (1 << (NTSC_RGB565_SHIFT - NTSC_LEVEL_SHIFT - 1)) +
+                           (NTSC_RGB565_BIAS << NTSC_RGB565_SHIFT);
+
+    for (uint line = 0; line < NTSC_PALETTE_LINES; line++) {
+        for (uint phase = 0; phase < 4; phase++) {
+            for (uint byte = 0; byte < 256; byte++) {
+                // High byte RRRRRGGG: red and the upper green bits, which also
+                // fill the lowest bit of the 8-bit green
+                const int32_t red = (byte >> 3) << 3 | byte >> 5;
+                const int32_t green_high = (byte & 7) << 5 | (byte & 7) >> 1;
+                ntsc_rgb565_high[line][phase][byte] = ntsc_rgb565_signal(line, phase, 0, red, green_high);
+
+                // Low byte GGGBBBBB: lower green bits and blue
+                const int32_t green_low = (byte >> 5) << 2;
+                const int32_t blue = (byte & 31) << 3 | (byte & 31) >> 2;
+                ntsc_rgb565_low[line][phase][byte] = ntsc_rgb565_signal(line, phase, blue, 0, green_low) + offset;
+            }
         }
+    }
 
-        // Fill remainder with blanking level
-        while (buffer_ptr < output_buffer + NTSC_SAMPLES_PER_LINE)
-            *buffer_ptr++ = NTSC_LEVEL_BLANK;
+    for (int level = 0; level < (int) count_of(ntsc_rgb565_samples); level++)
+        ntsc_rgb565_samples[level] = NTSC_SAMPLE(MIN(MAX(level - NTSC_LEVEL(NTSC_RGB565_BIAS), 0), NTSC_LEVEL_MAX));
+}
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_reverse_palette
+ * Purpose: Reverse the order of palette entries first to last - 1
+ * =========================================================================== */
+static inline void ntsc_reverse_palette(ntsc_palette_entry_t *first, ntsc_palette_entry_t *last) {
+    while (first < --last) {
+        const ntsc_palette_entry_t entry = *first;
+        *first++ = *last;
+        *last = entry;
     }
-    // Generate active video scanlines
-    else if (scanline_number >= NTSC_VSYNC_LINES + NTSC_VBLANK_TOP &&
-             scanline_number < NTSC_VSYNC_LINES + NTSC_VBLANK_TOP + NTSC_FRAME_HEIGHT) {
-        // Skip horizontal blanking interval
-        buffer_ptr += NTSC_ACTIVE_START;
+}
 
-        // Reset framebuffer pointer at start of first visible scanline
-        if (scanline_number == NTSC_VSYNC_LINES + NTSC_VBLANK_TOP) {
-            current_pixel_ptr = ntsc_framebuffer;
-#if !NDEBUG
-            ntsc_is_rendering_active = 1;
+/* ===========================================================================
+ * Function: ntsc_rotate_palette
+ * Purpose: Cycle `count` palette entries from `first` on by `steps` places,
+ *          entry first + i moves to first + (i + steps) % count
+ * The encoded entries are moved as they are, no color is computed again.
+ * Without NTSC_DOUBLE_PALETTE the change shows on the line being encoded,
+ * call it right after ntsc_wait_vsync() to keep it out of the picture.
+ * =========================================================================== */
+static void ntsc_rotate_palette(const uint8_t first, const uint count, const int steps) {
+    if (count < 2 || first + count > 256)
+        return;
+    const uint shift = (uint) (steps % (int) count + (int) count) % count;
+    if (!shift)
+        return;
+
+    // Rotation by three reversals, in place, in each palette
+    for (uint line = 0; line < NTSC_PALETTE_LINES; line++) {
+        ntsc_palette_entry_t *entries = (ntsc_palette_entry_t *) (ntsc_edit_palette + line * NTSC_PALETTE_SIZE) + first;
+        ntsc_reverse_palette(entries, entries + count);
+        ntsc_reverse_palette(entries, entries + shift);
+        ntsc_reverse_palette(entries + shift, entries + count);
+    }
+
+#if !NTSC_DOUBLE_PALETTE
+    ntsc_palette_changed(first, count);
 #endif
-        }
+}
+
+#if NTSC_DOUBLE_PALETTE
+/* ===========================================================================
+ * Function: ntsc_commit_palette
+ * Purpose: Queue the back palette to be shown from the next frame on
+ * The copy happens at the next vertical blanking, changes made to the back
+ * palette before then are included. Call ntsc_wait_vsync() first to keep
+ * changes for a later frame out of it.
+ * =========================================================================== */
+static inline void ntsc_commit_palette() {
+    ntsc_palette_commit_pending = true;
+}
+#endif
+
+#if NTSC_DMA_ENGINE == NTSC_DMA_CONTROL_LIST
+/* ===========================================================================
+ * Function: ntsc_build_control_list
+ * Purpose: Build the per-frame control block table for the data channel
+ * =========================================================================== */
+static void ntsc_build_control_list(volatile void *sink_addr, const uint dreq) {
+    // Data channel configuration shared by all blocks, chaining back to the
+    // control channel so the next block is loaded as soon as one completes
+    dma_channel_config data_config = dma_channel_get_default_config(ntsc_dma_chan_primary);
+    channel_config_set_transfer_data_size(&data_config, NTSC_DMA_TRANSFER_SIZE);
+    channel_config_set_read_increment(&data_config, true);
+    channel_config_set_write_increment(&data_config, false);
+    channel_config_set_dreq(&data_config, dreq);
+    channel_config_set_chain_to(&data_config, ntsc_dma_chan_control);
+    channel_config_set_irq_quiet(&data_config, true);
+    const uint32_t quiet_ctrl = channel_config_get_ctrl_value(&data_config);
+    channel_config_set_irq_quiet(&data_config, false);
+    const uint32_t wake_ctrl = channel_config_get_ctrl_value(&data_config);
+
+    ntsc_dma_block_t *block = ntsc_dma_blocks;
+
+    for (uint line = 0; line < NTSC_TOTAL_LINES; line++) {
+        const uint field = ntsc_field_of_line(line);
+        const uint field_line = line - field * NTSC_FIELD_LINES;
+        bool wake = false;
 
-        // Process all pixels in the scanline
-        for (int pixel_index = 0; pixel_index < NTSC_FRAME_WIDTH; pixel_index++) {
-            // Read one graphics pixel
-            const uint8_t pixel_color = *current_pixel_ptr++;
-
-            // Write 4 NTSC phase values for this pixel
-            // Using 32-bit writes for efficiency (2 phase values at once)
-            // Phase offset alternates: 0,2,0,2... for proper color encoding
-            const uint32_t phase_offset = pixel_index & 1 ? 2 : 0;
-            *(uint32_t *) buffer_ptr = *(uint32_t *) (ntsc_palette + pixel_color * 4 + phase_offset);
-            buffer_ptr += 2;
+        if (ntsc_vsync_template(line)) {
+            block->read_addr = ntsc_vsync_template(line);
+        } else if (field_line >= NTSC_ACTIVE_FIRST_LINE && field_line < NTSC_ACTIVE_END_LINE) {
+            const uint row = (field_line - NTSC_ACTIVE_FIRST_LINE) / NTSC_LINE_REPEAT;
+#if NTSC_LINE_CACHE
+            // Sync and burst from the line's blank template, active samples
+            // straight from the row's cache entry, repeated rows included,
+            // then the template's blanking tail
+            *block++ = (ntsc_dma_block_t) {
+                .ctrl = quiet_ctrl, .write_addr = sink_addr,
+                .transfer_count = NTSC_ACTIVE_START / NTSC_SAMPLES_PER_TRANSFER, .read_addr = ntsc_blank_template(line)
+            };
+            *block++ = (ntsc_dma_block_t) {
+                .ctrl = quiet_ctrl, .write_addr = sink_addr,
+                .transfer_count = NTSC_ACTIVE_SAMPLES / NTSC_SAMPLES_PER_TRANSFER, .read_addr = ntsc_line_cache[NTSC_FIELD_ROW(field, row)]
+            };
+            block->read_addr = ntsc_blank_template(line) + NTSC_ACTIVE_START + NTSC_ACTIVE_SAMPLES;
+            block->ctrl = quiet_ctrl;
+            block->write_addr = sink_addr;
+            block->transfer_count = (NTSC_LINE_BUFFER_SIZE - NTSC_ACTIVE_START - NTSC_ACTIVE_SAMPLES) / NTSC_SAMPLES_PER_TRANSFER;
+            block++;
+            continue;
+#else
+            // Repeated rows are sent from the same ring slot
+            const bool last_repeat = (field_line - NTSC_ACTIVE_FIRST_LINE) % NTSC_LINE_REPEAT == NTSC_LINE_REPEAT - 1;
+            block->read_addr = ntsc_line_ring[row % NTSC_LINE_RING_SIZE];
+            // Wake up when a ring half has been transmitted and there are rows left to encode
+            wake = last_repeat && (row + 1) % NTSC_LINES_PER_IRQ == 0 && row + 1 + NTSC_LINES_PER_IRQ < NTSC_FIELD_ROWS;
+#endif
+        } else {
+            block->read_addr = ntsc_blank_template(line);
         }
+
+        // Once per frame wake-up while the last line plays, to rewind the table,
+        // and with interlace once at the end of the first field
+        if (line == NTSC_TOTAL_LINES - 2 || (NTSC_INTERLACE && line == NTSC_FIELD_LINES - 2))
+            wake = true;
+
+        block->ctrl = wake ? wake_ctrl : quiet_ctrl;
+        block->write_addr = sink_addr;
+        block->transfer_count = NTSC_TRANSFERS_PER_LINE;
+        block++;
     }
-    // Generate vertical blanking lines after active video
-    else if (scanline_number == NTSC_VSYNC_LINES + NTSC_VBLANK_TOP + NTSC_FRAME_HEIGHT ||
-             scanline_number == NTSC_VSYNC_LINES + NTSC_VBLANK_TOP + NTSC_FRAME_HEIGHT + 1) {
-#if !NDEBUG
-        // Mark end of active video on first blanking line
-        if (scanline_number == NTSC_VSYNC_LINES + NTSC_VBLANK_TOP + NTSC_FRAME_HEIGHT) {
-            ntsc_is_rendering_active = 0;
-            ntsc_frame_counter++;
-        }
+
+    // NULL trigger ends the chain with an IRQ in case the rewind was missed
+    ntsc_dma_blocks[NTSC_DMA_BLOCK_COUNT] = (ntsc_dma_block_t) {
+        .ctrl = quiet_ctrl, .write_addr = sink_addr, .transfer_count = 0, .read_addr = NULL
+    };
+}
+
+/* ===========================================================================
+ * Function: ntsc_block_on_air
+ * Purpose: Control block the data channel is transmitting, from the control
+ * channel's position in the table, equal to the scanline without the line cache
+ * =========================================================================== */
+static inline uint ntsc_block_on_air() {
+    // The control channel loads the next block right after the data channel
+    // completes, wait for it so the read pointer reflects the line on air
+    while (dma_channel_is_busy(ntsc_dma_chan_control))
+        tight_loop_contents();
+    const ntsc_dma_block_t *next_block = (const ntsc_dma_block_t *) (uintptr_t) dma_hw->ch[ntsc_dma_chan_control].read_addr;
+    return next_block - ntsc_dma_blocks - 1;
+}
+
+/* ===========================================================================
+ * Function: ntsc_current_scanline
+ * Purpose: Scanline on air, 0 to NTSC_TOTAL_LINES - 1 from the start of the
+ * frame (the first vertical sync line)
+ * =========================================================================== */
+static inline uint ntsc_current_scanline() {
+    const uint block = ntsc_block_on_air();
+#if NTSC_LINE_CACHE
+    // Active lines take NTSC_BLOCKS_PER_ACTIVE_LINE blocks, other lines one
+    const uint field_blocks = NTSC_FIELD_LINES + (NTSC_BLOCKS_PER_ACTIVE_LINE - 1) * NTSC_ACTIVE_LINES;
+    const uint field = NTSC_INTERLACE && block >= field_blocks;
+    uint field_line = block - field * field_blocks;
+    if (field_line >= NTSC_ACTIVE_FIRST_LINE) {
+        const uint active_block = field_line - NTSC_ACTIVE_FIRST_LINE;
+        field_line = active_block < NTSC_BLOCKS_PER_ACTIVE_LINE * NTSC_ACTIVE_LINES ?
+                     NTSC_ACTIVE_FIRST_LINE + active_block / NTSC_BLOCKS_PER_ACTIVE_LINE :
+                     field_line - (NTSC_BLOCKS_PER_ACTIVE_LINE - 1) * NTSC_ACTIVE_LINES;
+    }
+    const uint line = field * NTSC_FIELD_LINES + field_line;
+#else
+    const uint line = block;
 #endif
-        // Skip horizontal blanking interval
-        buffer_ptr += NTSC_ACTIVE_START;
+    // Past the end while the chain waits at the terminator for the rewind
+    return MIN(line, NTSC_TOTAL_LINES - 1);
+}
 
-        // Fill the active portion with blanking level
-        // Width = NTSC_FRAME_WIDTH * 2 because each pixel generates 2 samples
-        for (int i = 0; i < NTSC_FRAME_WIDTH * 2; i++)
-            *buffer_ptr++ = NTSC_LEVEL_BLANK;
+#if NTSC_LINE_CACHE
+/* ===========================================================================
+ * Function: ntsc_refresh_line_cache
+ * Purpose: Encode dirty rows into the line cache, called during vertical
+ * blanking when no cache row is on air
+ * At most NTSC_CACHE_ROWS_PER_FRAME rows are encoded, the scan resumes
+ * after the last one on the next frame so no row is starved
+ * =========================================================================== */
+static inline void ntsc_refresh_line_cache() {
+    uint row = ntsc_cache_scan_row;
+    uint budget = NTSC_CACHE_ROWS_PER_FRAME;
+
+    for (uint scanned = 0; scanned < NTSC_FRAME_HEIGHT && budget; scanned++) {
+        if (ntsc_dirty_rows[row]) {
+            // Clear first, pixels drawn while the row is encoded mark it again
+            ntsc_dirty_rows[row] = 0;
+            __dmb();
+            ntsc_encode_row(ntsc_line_cache[row], row);
+            budget--;
+        }
+        if (++row == NTSC_FRAME_HEIGHT)
+            row = 0;
     }
+    ntsc_cache_scan_row = row;
 }
+#endif
 
 /* ===========================================================================
- * Function: ntsc_set_color
- * Purpose: Configure a color palette entry for NTSC encoding
+ * Function: ntsc_start_field
+ * Purpose: Vertical blanking work before field `field`: refresh the line
+ * cache, or encode the field's first ring of active lines
  * =========================================================================== */
-static void ntsc_set_color(const uint8_t palette_index, const uint8_t blue, const uint8_t red, const uint8_t green) {
-    // Calculate NTSC luminance using standard weights
-    // Y = 0.587*G + 0.114*B + 0.299*R
-    // Using integer math: (150*G + 29*B + 77*R) / 256
-    const int32_t luminance = (150 * green + 29 * blue + 77 * red + 128) / 256;
+static inline void ntsc_start_field(const uint field) {
+#if NTSC_LINE_CACHE
+    (void) field;
+    ntsc_refresh_line_cache();
+#else
+    for (uint row = 0; row < NTSC_LINE_RING_SIZE && row < NTSC_FIELD_ROWS; row++)
+        ntsc_encode_active_line(ntsc_line_ring[row], NTSC_FIELD_ROW(field, row));
+#endif
+}
+
+/* ===========================================================================
+ * Function: ntsc_dma_irq_handler
+ * Purpose: Refill the line ring (or the line cache) and rewind the control
+ * block table
+ * =========================================================================== */
+static void __time_critical_func(ntsc_dma_irq_handler)() {
+#if NTSC_STATS
+    const uint32_t start = systick_hw->cvr;
+#endif
+    NTSC_DMA_INTS = 1u << ntsc_dma_chan_primary;
+
+    const uint current_line = ntsc_block_on_air();
+
+    if (current_line >= NTSC_DMA_BLOCK_COUNT - 1) {
+        // Rewind to the top of the table before the last line completes
+        // If the chain already stopped at the terminator, restart it right away
+        const bool stalled = current_line != NTSC_DMA_BLOCK_COUNT - 1;
+        dma_channel_set_read_addr(ntsc_dma_chan_control, ntsc_dma_blocks, stalled);
+
+        ntsc_end_of_frame();
 
-    // Pre-calculated chrominance modulation factors
-    // These compensate for phase shifts in the NTSC encoding
-    // Original formula: signal = Y + 0.4921*(B-Y)*sin(θ) + 0.8773*(R-Y)*cos(θ)
+        // Vertical blanking leaves plenty of time before the first active line
+        ntsc_start_field(0);
+#if NTSC_STATS
+        if (stalled)
+            ntsc_stats.late_lines++;
+        ntsc_stats_record(&ntsc_stats.blank, start);
+#endif
+        return;
+    }
+
+#if NTSC_INTERLACE
+    // The end of the first field is the only other wake-up in the vertical
+    // blanking, with the line cache the only other wake-up at all
+    if (NTSC_LINE_CACHE || (current_line >= NTSC_ACTIVE_END_LINE && current_line < NTSC_FIELD_LINES + NTSC_ACTIVE_FIRST_LINE)) {
+        ntsc_end_of_frame();
+        ntsc_start_field(1);
+#if NTSC_STATS
+        ntsc_stats_record(&ntsc_stats.blank, start);
+#endif
+        return;
+    }
+#endif
 
-    // Phase 0° and 180° components
-    const int32_t blue_chroma_0 = (blue - luminance) * 441; // (B-Y) * 0.4921 * scale
-    const int32_t red_chroma_0 = (red - luminance) * 1361; // (R-Y) * 0.8773 * scale
+#if !NTSC_LINE_CACHE
+    const uint field = ntsc_field_of_line(current_line);
+    const uint field_line = current_line - field * NTSC_FIELD_LINES;
+    if (field_line >= NTSC_ACTIVE_FIRST_LINE && field_line < NTSC_ACTIVE_END_LINE) {
+        ntsc_is_rendering_active = 1;
+        // Rows of the half that just finished are replaced by the rows
+        // following the half that is transmitting now
+        const uint current_row = (field_line - NTSC_ACTIVE_FIRST_LINE) / NTSC_LINE_REPEAT;
+        const uint first_row = current_row / NTSC_LINES_PER_IRQ * NTSC_LINES_PER_IRQ + NTSC_LINES_PER_IRQ;
+        for (uint row = first_row; row < first_row + NTSC_LINES_PER_IRQ && row < NTSC_FIELD_ROWS; row++)
+            ntsc_encode_active_line(ntsc_line_ring[row % NTSC_LINE_RING_SIZE], NTSC_FIELD_ROW(field, row));
+#if NTSC_STATS
+        // Refilled rows already on air, or past, were sent half old
+        const uint field_line_after = ntsc_block_on_air() - field * NTSC_FIELD_LINES;
+        if (field_line_after >= NTSC_ACTIVE_FIRST_LINE + first_row * NTSC_LINE_REPEAT && field_line_after < NTSC_FIELD_LINES)
+            ntsc_stats.late_lines += MIN((field_line_after - NTSC_ACTIVE_FIRST_LINE) / NTSC_LINE_REPEAT - first_row + 1, NTSC_LINES_PER_IRQ);
+        ntsc_stats_record(&ntsc_stats.active, start);
+#endif
+    }
+#endif
+}
 
-    // Phase 90° and 270° components
-    const int32_t blue_chroma_90 = (blue - luminance) * 764; // (B-Y) * 0.4921 * scale
-    const int32_t red_chroma_90 = (red - luminance) * -786; // (R-Y) * 0.8773 * scale
+/* ===========================================================================
+ * Function: ntsc_setup_dma
+ * Purpose: Set up the control list engine, ntsc_start_dma() starts it
+ * =========================================================================== */
+static inline void ntsc_setup_dma(volatile void *sink_addr, const uint dreq) {
+    // Allocate data and control DMA channels
+    ntsc_dma_chan_primary = dma_claim_unused_channel(true);
+    ntsc_dma_chan_control = dma_claim_unused_channel(true);
 
-    // Generate composite signal values for each subcarrier phase
+    ntsc_build_control_list(sink_addr, dreq);
 
-    // Phase 0°: Y + chroma
-    int32_t composite_signal = (luminance * 1792 + blue_chroma_0 + red_chroma_0 + 2 * 65536 + 32768) / 65536;
-    ntsc_palette[palette_index * 4] = composite_signal < 0 ? 0 : composite_signal;
+    // Control channel copies one 4-word block per trigger into the data
+    // channel's alias 3 registers, the write ring wraps back to CTRL
+    dma_channel_config control_config = dma_channel_get_default_config(ntsc_dma_chan_control);
+    channel_config_set_transfer_data_size(&control_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&control_config, true);
+    channel_config_set_write_increment(&control_config, true);
+    channel_config_set_ring(&control_config, true, __builtin_ctz(sizeof(ntsc_dma_block_t))); // One block wide write ring, 16 bytes
 
-    // Phase 90°: Y + chroma(90°)
-    composite_signal = (luminance * 1792 + blue_chroma_90 + red_chroma_90 + 2 * 65536 + 32768) / 65536;
-    ntsc_palette[palette_index * 4 + 1] = composite_signal < 0 ? 0 : composite_signal;
+    dma_channel_configure(
+        ntsc_dma_chan_control,
+        &control_config,
+        &dma_hw->ch[ntsc_dma_chan_primary].al3_ctrl, // Destination: data channel registers
+        ntsc_dma_blocks, // Source: control block table
+        sizeof(ntsc_dma_block_t) / sizeof(uint32_t), // One block per trigger
+        false // Don't start yet
+    );
 
-    // Phase 180°: Y - chroma
-    composite_signal = (luminance * 1792 - blue_chroma_0 - red_chroma_0 + 2 * 65536 + 32768) / 65536;
-    ntsc_palette[palette_index * 4 + 2] = composite_signal < 0 ? 0 : composite_signal;
+#if NTSC_LINE_CACHE
+    // Encode every row once, later frames only encode dirty rows
+    for (uint row = 0; row < NTSC_FRAME_HEIGHT; row++)
+        ntsc_encode_row(ntsc_line_cache[row], row);
+#else
+    // Encode the first ring of active lines
+    ntsc_start_field(0);
+#endif
 
-    // Phase 270°: Y - chroma(90°)
-    composite_signal = (luminance * 1792 - blue_chroma_90 - red_chroma_90 + 2 * 65536 + 32768) / 65536;
-    ntsc_palette[palette_index * 4 + 3] = composite_signal < 0 ? 0 : composite_signal;
+    // Only wake-up blocks and the list terminator raise the interrupt
+    dma_irqn_set_channel_mask_enabled(NTSC_DMA_IRQ_INDEX, 1u << ntsc_dma_chan_primary, true);
 }
 
+/* ===========================================================================
+ * Function: ntsc_start_dma
+ * Purpose: Start video generation by loading the first control block
+ * =========================================================================== */
+static inline void ntsc_start_dma() {
+    dma_start_channel_mask(1u << ntsc_dma_chan_control);
+}
+#else
 /* ===========================================================================
  * Function: ntsc_dma_irq_handler
  * Purpose: Handle DMA transfer completion and prepare next scanline
  * =========================================================================== */
 static void __time_critical_func(ntsc_dma_irq_handler)() {
-    static size_t current_scanline = 0;
+    const uint current_scanline = ntsc_next_scanline;
+#if NTSC_STATS
+    const uint32_t start = systick_hw->cvr;
+#endif
     // Read and clear DMA interrupt flags
-    const volatile uint32_t interrupt_flags = dma_hw->ints0;
-    dma_hw->ints0 = interrupt_flags;
-
-    const uint8_t scanline_buffer_index = interrupt_flags & (1u << ntsc_dma_chan_secondary) ? 1 : 0;
-    // Determine which channel completed and prepare its buffer
-    ntsc_generate_scanline(ntsc_scanline_buffers[scanline_buffer_index], current_scanline);
-    if (scanline_buffer_index) {
-        dma_channel_set_read_addr(ntsc_dma_chan_secondary, ntsc_scanline_buffers[scanline_buffer_index], false);
+    const volatile uint32_t interrupt_flags = NTSC_DMA_INTS;
+    NTSC_DMA_INTS = interrupt_flags;
+
+    const bool completed_secondary = interrupt_flags & (1u << ntsc_dma_chan_secondary);
+    // Determine which channel completed and queue its next scanline
+    const ntsc_sample_t *scanline = ntsc_generate_scanline(current_scanline);
+#if NTSC_STATS
+    // The other channel finished meanwhile and chained back into this one
+    // before it was queued, so this channel already restarted with stale data
+    if (dma_channel_is_busy(completed_secondary ? ntsc_dma_chan_secondary : ntsc_dma_chan_primary))
+        ntsc_stats.late_lines++;
+#endif
+    if (completed_secondary) {
+        dma_channel_set_read_addr(ntsc_dma_chan_secondary, scanline, false);
     } else {
-        dma_channel_set_read_addr(ntsc_dma_chan_primary, ntsc_scanline_buffers[scanline_buffer_index], false);
+        dma_channel_set_read_addr(ntsc_dma_chan_primary, scanline, false);
     }
+#if NTSC_STATS
+    const uint field_line = current_scanline - ntsc_field_of_line(current_scanline) * NTSC_FIELD_LINES;
+    ntsc_stats_record(ntsc_vsync_template(current_scanline) ? &ntsc_stats.sync :
+                      field_line < NTSC_ACTIVE_FIRST_LINE || field_line >= NTSC_ACTIVE_END_LINE ?
+                      &ntsc_stats.blank : &ntsc_stats.active, start);
+#endif
 
     // Advance to the next scanline with wraparound
-    if (++current_scanline >= NTSC_TOTAL_LINES) {
-        current_scanline = 0;
-    }
+    ntsc_next_scanline = current_scanline + 1 < NTSC_TOTAL_LINES ? current_scanline + 1 : 0;
 }
 
-
 /* ===========================================================================
- * Function: ntsc_init
- * Purpose: Initialize the complete NTSC video generation system
+ * Function: ntsc_current_scanline
+ * Purpose: Scanline on air, 0 to NTSC_TOTAL_LINES - 1 from the start of the
+ * frame (the first vertical sync line)
+ * Follows the interrupts, so it lags by one line while an interrupt is
+ * pending or running
  * =========================================================================== */
-static inline void ntsc_init() {
-    /* Clock Configuration
-     * 315 MHz is the PERFECT frequency for NTSC video generation!
-     * NTSC color burst is exactly 315/88 MHz = 3.579545... MHz
-     * 315 MHz / 22 = 315/22 MHz = 14.318181... MHz (exactly 4x color burst)
-     * 14.318181 MHz / 4 = 3.579545 MHz (EXACT NTSC color burst frequency)
-     * This configuration provides PERFECT NTSC timing with 0% error! */
-    const uint32_t system_clock_khz = 315000;
-    const uint32_t pwm_period_cycles = 11;
-
-    vreg_set_voltage(VREG_VOLTAGE_1_30);
-    set_sys_clock_khz(system_clock_khz, true);
-
-    // Configure PWM output pin
-    gpio_set_function(NTSC_PIN_OUTPUT, GPIO_FUNC_PWM);
-    const uint pwm_slice = pwm_gpio_to_slice_num(NTSC_PIN_OUTPUT);
-
-    // Configure PWM for video signal generation
-    pwm_config pwm_cfg = pwm_get_default_config();
-    pwm_config_set_clkdiv(&pwm_cfg, 2.0f); // 2x clock division
-
-    pwm_init(pwm_slice, &pwm_cfg, true);
-    pwm_set_wrap(pwm_slice, pwm_period_cycles - 1);
-
-    // Get PWM compare register address for DMA writes
-    volatile void *pwm_compare_addr = &pwm_hw->slice[pwm_slice].cc;
-    // Offset by 2 bytes to write to the upper 16 bits (channel B)
-    pwm_compare_addr = (volatile void *) ((uintptr_t) pwm_compare_addr + 2);
+static inline uint ntsc_current_scanline() {
+    return (ntsc_next_scanline + NTSC_TOTAL_LINES - 2) % NTSC_TOTAL_LINES;
+}
 
+/* ===========================================================================
+ * Function: ntsc_setup_dma
+ * Purpose: Set up the ping-pong DMA channels, ntsc_start_dma() starts them
+ * =========================================================================== */
+static inline void ntsc_setup_dma(volatile void *sink_addr, const uint dreq) {
     // Allocate DMA channels for ping-pong operation
     ntsc_dma_chan_primary = dma_claim_unused_channel(true);
     ntsc_dma_chan_secondary = dma_claim_unused_channel(true);
 
     // Configure primary DMA channel
     dma_channel_config primary_config = dma_channel_get_default_config(ntsc_dma_chan_primary);
-    channel_config_set_transfer_data_size(&primary_config, DMA_SIZE_16);
+    channel_config_set_transfer_data_size(&primary_config, NTSC_DMA_TRANSFER_SIZE);
     channel_config_set_read_increment(&primary_config, true); // Increment source
     channel_config_set_write_increment(&primary_config, false); // Fixed destination
-    channel_config_set_dreq(&primary_config, DREQ_PWM_WRAP0 + pwm_slice);
+    channel_config_set_dreq(&primary_config, dreq);
     channel_config_set_chain_to(&primary_config, ntsc_dma_chan_secondary); // Chain to secondary
 
     dma_channel_configure(
         ntsc_dma_chan_primary,
         &primary_config,
-        pwm_compare_addr, // Destination: PWM register
-        ntsc_scanline_buffers[0], // Source: Buffer 0
-        NTSC_SAMPLES_PER_LINE, // Transfer count
+        sink_addr, // Destination: PWM register
+        ntsc_generate_scanline(0), // Source: scanline 0
+        NTSC_TRANSFERS_PER_LINE, // Transfer count
         false // Don't start yet
     );
 
     // Configure a secondary DMA channel (mirrors primary, chains back)
     dma_channel_config secondary_config = dma_channel_get_default_config(ntsc_dma_chan_secondary);
-    channel_config_set_transfer_data_size(&secondary_config, DMA_SIZE_16);
+    channel_config_set_transfer_data_size(&secondary_config, NTSC_DMA_TRANSFER_SIZE);
     channel_config_set_read_increment(&secondary_config, true);
     channel_config_set_write_increment(&secondary_config, false);
-    channel_config_set_dreq(&secondary_config, DREQ_PWM_WRAP0 + pwm_slice);
+    channel_config_set_dreq(&secondary_config, dreq);
     channel_config_set_chain_to(&secondary_config, ntsc_dma_chan_primary); // Chain back
 
     dma_channel_configure(
         ntsc_dma_chan_secondary,
         &secondary_config,
-        pwm_compare_addr, // Destination: PWM register
-        ntsc_scanline_buffers[1], // Source: Buffer 1
-        NTSC_SAMPLES_PER_LINE, // Transfer count
+        sink_addr, // Destination: PWM register
+        ntsc_generate_scanline(1), // Source: scanline 1
+        NTSC_TRANSFERS_PER_LINE, // Transfer count
         false // Don't start yet
     );
 
-    // Pre-fill buffers with the first two scanlines
-    ntsc_generate_scanline(ntsc_scanline_buffers[0], 0);
-    ntsc_generate_scanline(ntsc_scanline_buffers[1], 1);
-
     // Enable DMA completion interrupts for both channels
-    dma_set_irq0_channel_mask_enabled(1u << ntsc_dma_chan_primary | 1u << ntsc_dma_chan_secondary,true);
-
-    // Install and enable interrupt handler
-    irq_set_exclusive_handler(DMA_IRQ_0, ntsc_dma_irq_handler);
-    irq_set_enabled(DMA_IRQ_0, true);
+    dma_irqn_set_channel_mask_enabled(NTSC_DMA_IRQ_INDEX, 1u << ntsc_dma_chan_primary | 1u << ntsc_dma_chan_secondary, true);
+}
 
-    // Start video generation by triggering the first DMA transfer
+/* ===========================================================================
+ * Function: ntsc_start_dma
+ * Purpose: Start video generation by triggering the first DMA transfer
+ * =========================================================================== */
+static inline void ntsc_start_dma() {
     dma_start_channel_mask(1u << ntsc_dma_chan_primary);
 }
+#endif
+
+/* ===========================================================================
+ * Function: ntsc_wait_frame_start
+ * Purpose: Wait for the vertical blanking after the last field of a frame,
+ *          the second field's with interlace, and return ntsc_frame_counter
+ * Returns right away when already in that blanking. ntsc_frame_counter
+ * counts fields and reaches a multiple of NTSC_FIELDS at the end of every
+ * frame, the returned count is the frame_start of ntsc_rows_sent()
+ * =========================================================================== */
+static inline uint32_t ntsc_wait_frame_start() {
+    while (1) {
+        // ntsc_is_rendering_active is cleared after the count is updated
+        if (!ntsc_is_rendering_active) {
+            const uint32_t frame = ntsc_frame_counter;
+            if (frame % NTSC_FIELDS == 0)
+                return frame;
+        }
+        ntsc_wait_vsync();
+    }
+}
+
+/* ===========================================================================
+ * Function: ntsc_rows_sent
+ * Purpose: Number of framebuffer rows, from row 0, the beam has sent of the
+ *          frame that ntsc_wait_frame_start() returned frame_start for
+ * With interlace a row counts once the second field has sent its row pair,
+ * so rows only count during that field. All NTSC_FRAME_HEIGHT rows count
+ * from the vertical blanking after it on
+ * =========================================================================== */
+static inline uint ntsc_rows_sent(const uint32_t frame_start) {
+    const uint32_t fields_ended = ntsc_frame_counter - frame_start;
+    if (fields_ended >= NTSC_FIELDS)
+        return NTSC_FRAME_HEIGHT;
+    // Earlier field, or the blanking before the last field's first row
+    if (fields_ended != NTSC_FIELDS - 1 || !ntsc_is_rendering_active)
+        return 0;
+    const uint line = ntsc_current_scanline();
+    const uint field_line = line - ntsc_field_of_line(line) * NTSC_FIELD_LINES;
+    if (field_line < NTSC_ACTIVE_FIRST_LINE)
+        return 0;
+    return MIN((field_line - NTSC_ACTIVE_FIRST_LINE) / NTSC_LINE_REPEAT * NTSC_FIELDS, NTSC_FRAME_HEIGHT);
+}
+
+#if NTSC_OUTPUT == NTSC_OUTPUT_DAC
+/* ===========================================================================
+ * Function: ntsc_init_output
+ * Purpose: Start the PIO resistor ladder DAC driver and return its DMA target
+ * One instruction writes each 8-bit sample to the NTSC_DAC_BITS pins and
+ * holds it for NTSC_SAMPLE_CYCLES cycles:
+ *   out pins, 8  [10]  ; 11 cycles per sample with NTSC-M
+ * Autopull refills the OSR with 4 packed samples from the TX FIFO, the
+ * code bits above NTSC_DAC_BITS fall outside the pin range
+ * =========================================================================== */
+static inline void ntsc_init_output(volatile void **sink_addr, uint *dreq) {
+    static uint16_t dac_program[1];
+    dac_program[0] = pio_encode_out(pio_pins, 8) | pio_encode_delay(NTSC_SAMPLE_CYCLES - 1);
+
+    const pio_program_t program = {
+        .instructions = dac_program,
+        .length = count_of(dac_program),
+        .origin = -1,
+    };
+    const uint offset = pio_add_program(NTSC_PIO, &program);
+    const uint sm = pio_claim_unused_sm(NTSC_PIO, true);
+
+    pio_sm_config sm_cfg = pio_get_default_sm_config();
+    sm_config_set_out_pins(&sm_cfg, NTSC_DAC_PIN_BASE, NTSC_DAC_BITS);
+    sm_config_set_out_shift(&sm_cfg, true, true, 32); // First sample in the lowest byte
+    sm_config_set_fifo_join(&sm_cfg, PIO_FIFO_JOIN_TX);
+    sm_config_set_wrap(&sm_cfg, offset, offset);
+    sm_config_set_clkdiv_int_frac(&sm_cfg, NTSC_CLOCK_DIVIDER, 0);
+
+    for (uint pin = NTSC_DAC_PIN_BASE; pin < NTSC_DAC_PIN_BASE + NTSC_DAC_BITS; pin++)
+        pio_gpio_init(NTSC_PIO, pin);
+    pio_sm_set_consecutive_pindirs(NTSC_PIO, sm, NTSC_DAC_PIN_BASE, NTSC_DAC_BITS, true);
+    pio_sm_init(NTSC_PIO, sm, offset, &sm_cfg);
+    pio_sm_set_enabled(NTSC_PIO, sm, true);
+
+    *sink_addr = &NTSC_PIO->txf[sm];
+    *dreq = pio_get_dreq(NTSC_PIO, sm, true);
+}
+#elif NTSC_SAMPLE_BITS == 8
+/* ===========================================================================
+ * Function: ntsc_init_output
+ * Purpose: Start the PIO PWM waveform generator and return its DMA target
+ * The program is a jump table with one NTSC_SAMPLE_CYCLES-cycle waveform
+ * (11 cycles with NTSC-M) per output level, each 8-bit sample is the address
+ * of the waveform to play:
+ *   level 0:      out pc, 8  side 0 [10]    ; 11 cycles low
+ *   level 1..10:  nop        side 1 [k - 1] ; k cycles high
+ *                 out pc, 8  side 0 [10 - k]; 11 - k cycles low
+ *   level 11:     out pc, 8  side 1 [10]    ; 11 cycles high
+ * The final `out pc` of every waveform fetches the next sample, autopull
+ * refills the OSR with 4 packed samples from the TX FIFO
+ * =========================================================================== */
+static inline void ntsc_init_output(volatile void **sink_addr, uint *dreq) {
+    static uint16_t waveform_program[2 * NTSC_SAMPLE_CYCLES];
+    const uint fetch = pio_encode_out(pio_pc, 8);
+
+    waveform_program[NTSC_SAMPLE(0)] = fetch | pio_encode_sideset(1, 0) | pio_encode_delay(NTSC_SAMPLE_CYCLES - 1);
+    for (uint level = 1; level < NTSC_SAMPLE_CYCLES; level++) {
+        waveform_program[NTSC_SAMPLE(level)] = pio_encode_nop() | pio_encode_sideset(1, 1) | pio_encode_delay(level - 1);
+        waveform_program[NTSC_SAMPLE(level) + 1] = fetch | pio_encode_sideset(1, 0) | pio_encode_delay(NTSC_SAMPLE_CYCLES - 1 - level);
+    }
+    waveform_program[NTSC_SAMPLE(NTSC_SAMPLE_CYCLES)] = fetch | pio_encode_sideset(1, 1) | pio_encode_delay(NTSC_SAMPLE_CYCLES - 1);
+
+    // Samples are absolute jump targets, so the program must sit at offset 0
+    const pio_program_t program = {
+        .instructions = waveform_program,
+        .length = count_of(waveform_program),
+        .origin = 0,
+    };
+    pio_add_program_at_offset(NTSC_PIO, &program, 0);
+    const uint sm = pio_claim_unused_sm(NTSC_PIO, true);
+
+    pio_sm_config sm_cfg = pio_get_default_sm_config();
+    sm_config_set_sideset(&sm_cfg, 1, false, false);
+    sm_config_set_sideset_pins(&sm_cfg, NTSC_PIN_OUTPUT);
+    sm_config_set_out_shift(&sm_cfg, true, true, 32); // First sample in the lowest byte
+    sm_config_set_fifo_join(&sm_cfg, PIO_FIFO_JOIN_TX);
+    sm_config_set_wrap(&sm_cfg, 0, count_of(waveform_program) - 1);
+    sm_config_set_clkdiv_int_frac(&sm_cfg, NTSC_CLOCK_DIVIDER, 0); // Same division as the PWM
+
+    pio_gpio_init(NTSC_PIO, NTSC_PIN_OUTPUT);
+    pio_sm_set_consecutive_pindirs(NTSC_PIO, sm, NTSC_PIN_OUTPUT, 1, true);
+    pio_sm_init(NTSC_PIO, sm, 0, &sm_cfg);
+    pio_sm_set_enabled(NTSC_PIO, sm, true);
+
+    *sink_addr = &NTSC_PIO->txf[sm];
+    *dreq = pio_get_dreq(NTSC_PIO, sm, true);
+}
+#else
+/* ===========================================================================
+ * Function: ntsc_init_output
+ * Purpose: Configure the PWM slice and return its DMA target
+ * =========================================================================== */
+static inline void ntsc_init_output(volatile void **sink_addr, uint *dreq) {
+    // Configure PWM output pin
+    gpio_set_function(NTSC_PIN_OUTPUT, GPIO_FUNC_PWM);
+    const uint pwm_slice = pwm_gpio_to_slice_num(NTSC_PIN_OUTPUT);
+
+    // Configure PWM for video signal generation
+    pwm_config pwm_cfg = pwm_get_default_config();
+    pwm_config_set_clkdiv(&pwm_cfg, (float) NTSC_CLOCK_DIVIDER); // 2x clock division with NTSC-M
+
+    pwm_init(pwm_slice, &pwm_cfg, true);
+    pwm_set_wrap(pwm_slice, NTSC_SAMPLE_CYCLES - 1);
+
+    // Get PWM compare register address for DMA writes
+    volatile void *pwm_compare_addr = &pwm_hw->slice[pwm_slice].cc;
+    // Offset by 2 bytes to write to the upper 16 bits (channel B)
+    *sink_addr = (volatile void *) ((uintptr_t) pwm_compare_addr + 2);
+    *dreq = DREQ_PWM_WRAP0 + pwm_slice;
+}
+#endif
+
+/* ===========================================================================
+ * Video Core
+ * ===========================================================================
+ * The core that installs the DMA interrupt handler is the video core: it
+ * services every DMA interrupt and encodes every active line. Interrupt
+ * masking, USB and other IRQ handlers on the other core never delay it,
+ * the NVIC is per core.
+ *
+ * Latency budget, one scanline is NTSC_SAMPLES_PER_LINE * NTSC_SAMPLE_CYCLES
+ * * NTSC_CLOCK_DIVIDER system clock cycles: 908 samples * 22 cycles = 19976
+ * cycles (63.4 us at 315 MHz) with NTSC-M, 9988 with NTSC-M on the DAC
+ * (157.5 MHz) and with PAL-M, 11280 with PAL-60 and 11360 with PAL-B/G,
+ * counted from the DMA interrupt being raised:
+ *  NTSC_DMA_PINGPONG:     one scanline, minus the time to encode one row
+ *  NTSC_DMA_CONTROL_LIST: NTSC_LINES_PER_IRQ scanlines for active lines,
+ *                         minus the time to encode that many rows, and one
+ *                         scanline for the frame rewind (a missed rewind
+ *                         costs one disturbed frame, not a lost sync)
+ * Everything the video core touches runs from and lives in RAM: the handler,
+ * the encoder, the line tables, the palette and the framebuffer. Flash
+ * erase/program on the application core therefore cannot stall it, as long
+ * as the video core is not made a multicore lockout victim (do not call
+ * multicore_lockout_victim_init() on it or use flash_safe_execute(), which
+ * would park it for the whole erase) and the video core runs no other code
+ * from flash. Only higher priority interrupts on the video core itself, and
+ * heavy bus contention on the framebuffer's SRAM banks, eat into the budget
+ * =========================================================================== */
+
+/* ===========================================================================
+ * Function: ntsc_start_video
+ * Purpose: Install the DMA interrupt handler on the calling core and start
+ * transmitting, the calling core becomes the video core
+ * =========================================================================== */
+static inline void ntsc_start_video() {
+#if NTSC_STATS
+    ntsc_stats_start();
+#endif
+    irq_set_exclusive_handler(NTSC_DMA_IRQ, ntsc_dma_irq_handler);
+    irq_set_priority(NTSC_DMA_IRQ, PICO_HIGHEST_IRQ_PRIORITY);
+    irq_set_enabled(NTSC_DMA_IRQ, true);
+
+    ntsc_start_dma();
+}
+
+/* ===========================================================================
+ * Function: ntsc_video_core_entry
+ * Purpose: Core 1 entry of the dedicated video core, services the DMA
+ * interrupt and sleeps in between, never leaving RAM
+ * =========================================================================== */
+static void __not_in_flash_func(ntsc_video_core_entry)() {
+    ntsc_start_video();
+    while (true)
+        __wfi();
+}
+
+/* ===========================================================================
+ * Function: ntsc_init_clock
+ * Purpose: Run the system clock at the video clock of the timing profile
+ * =========================================================================== */
+static inline void ntsc_init_clock() {
+    /* Clock Configuration
+     * 315 MHz is the PERFECT frequency for NTSC video generation!
+     * NTSC color burst is exactly 315/88 MHz = 3.579545... MHz
+     * 315 MHz / 22 = 315/22 MHz = 14.318181... MHz (exactly 4x color burst)
+     * 14.318181 MHz / 4 = 3.579545 MHz (EXACT NTSC color burst frequency)
+     * This configuration provides PERFECT NTSC timing with 0% error!
+     * The PAL clocks are the PLL settings closest to 4x their subcarrier,
+     * not integer kHz, so the PLL is set up directly */
+    vreg_set_voltage(ntsc_timing_profile.core_voltage);
+    set_sys_clock_pll(ntsc_timing_profile.pll_vco_hz, ntsc_timing_profile.pll_post_div1, ntsc_timing_profile.pll_post_div2);
+}
+
+/* ===========================================================================
+ * Function: ntsc_init_video_core
+ * Purpose: Initialize the complete NTSC video generation system with the DMA
+ * interrupt and line encoding hosted on video_core
+ * video_core is either the calling core, which keeps running the application
+ * between interrupts, or core 1 called from core 0, which launches core 1 as
+ * a dedicated video core and leaves core 0 entirely to the application
+ * (core 1 is then not available to multicore_launch_core1())
+ * =========================================================================== */
+static inline void ntsc_init_video_core(const uint video_core) {
+    hard_assert(video_core == get_core_num() || video_core == 1);
+
+    ntsc_init_clock();
+
+    // Precompute sync and blanking lines
+    ntsc_build_line_templates();
+#if NTSC_PIXEL_BITS == 16
+    ntsc_build_rgb565_tables();
+#elif NTSC_ARTIFACT_COLOR
+    // Fixed sample levels, independent of the palette
+    ntsc_build_group_palette();
+#endif
+
+#if defined(NTSC_PALETTE_COLORS) && NTSC_PHASE_DITHER
+    // Boot palette fitted at run time (see NTSC_PALETTE_COLORS)
+    static const uint32_t boot_colors[] = { NTSC_PALETTE_COLORS(NTSC_PALETTE_RGB) };
+    for (uint i = 0; i < count_of(boot_colors); i++)
+        ntsc_set_color(i, boot_colors[i] & 0xFF, boot_colors[i] >> 16 & 0xFF, boot_colors[i] >> 8 & 0xFF);
+#endif
+
+#if NTSC_DOUBLE_PALETTE
+    // Colors set before init show from the first frame on
+    memcpy(ntsc_palette, ntsc_back_palette, sizeof(ntsc_palette));
+    ntsc_palette_changed(0, 256);
+#elif defined(NTSC_PALETTE_COLORS)
+    // Tables derived from the boot palette
+    ntsc_palette_changed(0, 256);
+#endif
+
+    volatile void *sink_addr;
+    uint dreq;
+    ntsc_init_output(&sink_addr, &dreq);
+    ntsc_setup_dma(sink_addr, dreq);
+
+    if (video_core == get_core_num())
+        ntsc_start_video();
+    else
+        multicore_launch_core1(ntsc_video_core_entry);
+}
+
+/* ===========================================================================
+ * Function: ntsc_init
+ * Purpose: Initialize the complete NTSC video generation system, the calling
+ * core becomes the video core
+ * =========================================================================== */
+static inline void ntsc_init() {
+    ntsc_init_video_core(get_core_num());
+}
 #endif // RP2040_PWM_NTSC_H
@@ -0,0 +1,42 @@
+#ifndef NTSC_TV_VGA_PALETTE_H
+#define NTSC_TV_VGA_PALETTE_H
+
+// ------------------------------------------------------------
+// VGA 256-color palette (0xRRGGBB) as an NTSC_PALETTE_COLORS list
+// Shared by the demo and the simulator, included before ntsc-tv-out.h
+// ------------------------------------------------------------
+#define VGA_PALETTE_COLORS(COLOR) \
+        COLOR(0x000000) COLOR(0x0000AA) COLOR(0x00AA00) COLOR(0x00AAAA) COLOR(0xAA0000) COLOR(0xAA00AA) COLOR(0xAA5500) COLOR(0xAAAAAA) \
+        COLOR(0x555555) COLOR(0x5555FF) COLOR(0x55FF55) COLOR(0x55FFFF) COLOR(0xFF5555) COLOR(0xFF55FF) COLOR(0xFFFF55) COLOR(0xFFFFFF) \
+        COLOR(0x000000) COLOR(0x141414) COLOR(0x202020) COLOR(0x2C2C2C) COLOR(0x383838) COLOR(0x444444) COLOR(0x505050) COLOR(0x606060) \
+        COLOR(0x707070) COLOR(0x808080) COLOR(0x909090) COLOR(0xA0A0A0) COLOR(0xB4B4B4) COLOR(0xC8C8C8) COLOR(0xDCDCDC) COLOR(0xF0F0F0) \
+        COLOR(0x0000FF) COLOR(0x4100FF) COLOR(0x8200FF) COLOR(0xBE00FF) COLOR(0xFF00FF) COLOR(0xFF00BE) COLOR(0xFF0082) COLOR(0xFF0041) \
+        COLOR(0xFF0000) COLOR(0xFF4100) COLOR(0xFF8200) COLOR(0xFFBE00) COLOR(0xFFFF00) COLOR(0xBEFF00) COLOR(0x82FF00) COLOR(0x41FF00) \
+        COLOR(0x00FF00) COLOR(0x00FF41) COLOR(0x00FF82) COLOR(0x00FFBE) COLOR(0x00FFFF) COLOR(0x00BEFF) COLOR(0x0082FF) COLOR(0x0041FF) \
+        COLOR(0x8282FF) COLOR(0x9E82FF) COLOR(0xBE82FF) COLOR(0xDB82FF) COLOR(0xFF82FF) COLOR(0xFF82DB) COLOR(0xFF82BE) COLOR(0xFF829E) \
+        COLOR(0xFF8282) COLOR(0xFF9E82) COLOR(0xFFBE82) COLOR(0xFFDB82) COLOR(0xFFFF82) COLOR(0xDBFF82) COLOR(0xBEFF82) COLOR(0x9EFF82) \
+        COLOR(0x82FF82) COLOR(0x82FF9E) COLOR(0x82FFBE) COLOR(0x82FFDB) COLOR(0x82FFFF) COLOR(0x82DBFF) COLOR(0x82BEFF) COLOR(0x829EFF) \
+        COLOR(0xB6B6FF) COLOR(0xC6B6FF) COLOR(0xDBB6FF) COLOR(0xEBB6FF) COLOR(0xFFB6FF) COLOR(0xFFB6EB) COLOR(0xFFB6DB) COLOR(0xFFB6C6) \
+        COLOR(0xFFB6B6) COLOR(0xFFC6B6) COLOR(0xFFDBB6) COLOR(0xFFEBB6) COLOR(0xFFFFB6) COLOR(0xEBFFB6) COLOR(0xDBFFB6) COLOR(0xC6FFB6) \
+        COLOR(0xB6FFB6) COLOR(0xB6FFC6) COLOR(0xB6FFDB) COLOR(0xB6FFEB) COLOR(0xB6FFFF) COLOR(0xB6EBFF) COLOR(0xB6DBFF) COLOR(0xB6C6FF) \
+        COLOR(0x000071) COLOR(0x1C0071) COLOR(0x390071) COLOR(0x550071) COLOR(0x710071) COLOR(0x710055) COLOR(0x710039) COLOR(0x71001C) \
+        COLOR(0x710000) COLOR(0x711C00) COLOR(0x713900) COLOR(0x715500) COLOR(0x717100) COLOR(0x557100) COLOR(0x397100) COLOR(0x1C7100) \
+        COLOR(0x007100) COLOR(0x00711C) COLOR(0x007139) COLOR(0x007155) COLOR(0x007171) COLOR(0x005571) COLOR(0x003971) COLOR(0x001C71) \
+        COLOR(0x393971) COLOR(0x453971) COLOR(0x553971) COLOR(0x613971) COLOR(0x713971) COLOR(0x713961) COLOR(0x713955) COLOR(0x713945) \
+        COLOR(0x713939) COLOR(0x714539) COLOR(0x715539) COLOR(0x716139) COLOR(0x717139) COLOR(0x617139) COLOR(0x557139) COLOR(0x457139) \
+        COLOR(0x397139) COLOR(0x397145) COLOR(0x397155) COLOR(0x397161) COLOR(0x397171) COLOR(0x396171) COLOR(0x395571) COLOR(0x394571) \
+        COLOR(0x515171) COLOR(0x595171) COLOR(0x615171) COLOR(0x695171) COLOR(0x715171) COLOR(0x715169) COLOR(0x715161) COLOR(0x715159) \
+        COLOR(0x715151) COLOR(0x715951) COLOR(0x716151) COLOR(0x716951) COLOR(0x717151) COLOR(0x697151) COLOR(0x617151) COLOR(0x597151) \
+        COLOR(0x517151) COLOR(0x517159) COLOR(0x517161) COLOR(0x517169) COLOR(0x517171) COLOR(0x516971) COLOR(0x516171) COLOR(0x515971) \
+        COLOR(0x000041) COLOR(0x100041) COLOR(0x200041) COLOR(0x310041) COLOR(0x410041) COLOR(0x410031) COLOR(0x410020) COLOR(0x410010) \
+        COLOR(0x410000) COLOR(0x411000) COLOR(0x412000) COLOR(0x413100) COLOR(0x414100) COLOR(0x314100) COLOR(0x204100) COLOR(0x104100) \
+        COLOR(0x004100) COLOR(0x004110) COLOR(0x004120) COLOR(0x004131) COLOR(0x004141) COLOR(0x003141) COLOR(0x002041) COLOR(0x001041) \
+        COLOR(0x202041) COLOR(0x282041) COLOR(0x312041) COLOR(0x392041) COLOR(0x412041) COLOR(0x412039) COLOR(0x412031) COLOR(0x412028) \
+        COLOR(0x412020) COLOR(0x412820) COLOR(0x413120) COLOR(0x413920) COLOR(0x414120) COLOR(0x394120) COLOR(0x314120) COLOR(0x284120) \
+        COLOR(0x204120) COLOR(0x204128) COLOR(0x204131) COLOR(0x204139) COLOR(0x204141) COLOR(0x203941) COLOR(0x203141) COLOR(0x202841) \
+        COLOR(0x2D2D41) COLOR(0x312D41) COLOR(0x392D41) COLOR(0x3D2D41) COLOR(0x412D41) COLOR(0x412D3D) COLOR(0x412D39) COLOR(0x412D31) \
+        COLOR(0x412D2D) COLOR(0x41312D) COLOR(0x41392D) COLOR(0x413D2D) COLOR(0x41412D) COLOR(0x3D412D) COLOR(0x39412D) COLOR(0x31412D) \
+        COLOR(0x2D412D) COLOR(0x2D4131) COLOR(0x2D4139) COLOR(0x2D413D) COLOR(0x2D4141) COLOR(0x2D3D41) COLOR(0x2D3941) COLOR(0x2D3141) \
+        COLOR(0x000000) COLOR(0x000000) COLOR(0x000000) COLOR(0x000000) COLOR(0x000000) COLOR(0x000000) COLOR(0x000000) COLOR(0x000000)
+
+#endif